@@ -0,0 +1,154 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "allocations.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+
+    std::atomic<size_t> s_allocations{0};
+    std::atomic<size_t> s_bytes{0};
+
+    inline void count()
+    {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+#if defined(__GLIBC__)
+    // The usable size is what the allocator actually set aside, so it is
+    // the same when the block is allocated and when it is freed.
+    inline void *allocated(void *ptr)
+    {
+        if (ptr) {
+            s_bytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+        }
+        return ptr;
+    }
+
+    inline void released(void *ptr)
+    {
+        if (ptr) {
+            s_bytes.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+        }
+    }
+#endif
+
+} // namespace
+
+#if defined(__GLIBC__)
+
+// The benchmark binary replaces the allocation entry points and forwards them
+// to glibc's own implementation, which also catches calls made from Qt.
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+    count();
+    return allocated(__libc_malloc(size));
+}
+
+void *calloc(size_t count, size_t size)
+{
+    ::count();
+    return allocated(__libc_calloc(count, size));
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    count();
+    // The old block is only gone if realloc succeeded, or was asked to free it.
+    const size_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+    void *result = __libc_realloc(ptr, size);
+    if (result || (size == 0)) {
+        s_bytes.fetch_sub(old_size, std::memory_order_relaxed);
+    }
+    return allocated(result);
+}
+
+// Aligned allocations are forwarded too, because they are released with free.
+void *memalign(size_t alignment, size_t size)
+{
+    count();
+    return allocated(__libc_memalign(alignment, size));
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    void *result = memalign(alignment, size);
+    if (!result) {
+        return ENOMEM;
+    }
+    *ptr = result;
+    return 0;
+}
+
+void free(void *ptr)
+{
+    released(ptr);
+    __libc_free(ptr);
+}
+
+} // extern "C"
+
+bool bench::countsAllAllocations()
+{
+    return true;
+}
+
+#else
+
+void *operator new(size_t size)
+{
+    count();
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+bool bench::countsAllAllocations()
+{
+    return false;
+}
+
+#endif
+
+size_t bench::allocationCount()
+{
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+size_t bench::allocatedBytes()
+{
+    return s_bytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,24 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstddef>
+
+namespace bench {
+
+    // Returns the number of heap allocations made by the process so far.
+    //
+    // With glibc this counts every call to malloc, calloc and realloc, which
+    // includes the allocations made by Qt containers. Elsewhere only operator
+    // new is counted, so QString and QByteArray allocations are missed.
+    size_t allocationCount();
+
+    // Returns the number of bytes that are currently allocated, or zero when
+    // this is not tracked. Only glibc builds track it.
+    size_t allocatedBytes();
+
+    // Returns true if allocationCount() includes Qt's allocations.
+    bool countsAllAllocations();
+
+} // namespace bench
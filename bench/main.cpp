@@ -0,0 +1,378 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+// Measures how fast the API payloads are parsed into poe::types.
+//
+//     acquisition_bench --iterations 20 --history bench.jsonl
+//
+// Each run prints throughput and allocations per item for every payload kind,
+// and compares JSON with the binary format used for internal caches. It also
+// reads every cell of a large item tree, the way the item view does when it
+// is scrolled from top to bottom, sorts it by a text and a number column, runs
+// a few hundred saved searches over it, and reports how much memory the tree
+// uses for each item.
+// With --history, the results are also appended as one JSON line to a file,
+// so that runs from different builds can be compared over time.
+
+#include "allocations.h"
+#include "payloads.h"
+
+#include "model/itemfilter.h"
+#include "model/sortfiltermodel.h"
+#include "model/treemodel.h"
+#include "util/json.h"
+#include "util/spdlog_qt.h"
+
+static_assert(ACQUISITION_USE_SPDLOG);
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+// Payloads are parsed the same way UserStore parses them.
+constexpr auto JSON_MODE = json::Mode::Permissive;
+
+struct BenchResult
+{
+    QString name;
+    size_t payloads{0};
+    size_t bytes{0};
+    size_t items{0}; // List payloads count their entries.
+    double seconds{0.0};
+    double megabytes_per_second{0.0};
+    double items_per_second{0.0};
+    double allocations_per_item{0.0};
+    double bytes_per_item{0.0}; // Memory held afterwards, where it is measured.
+};
+
+struct BenchRun
+{
+    QString timestamp;
+    QString compiler;
+    unsigned seed{0};
+    int iterations{0};
+    bool counts_qt_allocations{false};
+    std::vector<BenchResult> results;
+};
+
+namespace {
+
+    size_t totalSize(const std::vector<QByteArray> &payloads)
+    {
+        size_t bytes = 0;
+        for (const auto &payload : payloads) {
+            bytes += static_cast<size_t>(payload.size());
+        }
+        return bytes;
+    }
+
+    // Times a number of passes over a set of payloads.
+    template<typename Pass>
+    BenchResult measure(const QString &name,
+                        const std::vector<QByteArray> &payloads,
+                        size_t items,
+                        int iterations,
+                        Pass &&pass)
+    {
+        BenchResult result;
+        result.name = name;
+        result.payloads = payloads.size();
+        result.bytes = totalSize(payloads);
+        result.items = items;
+
+        const size_t allocations_before = bench::allocationCount();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            pass();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        const size_t allocations = bench::allocationCount() - allocations_before;
+
+        const double total_items = static_cast<double>(items) * iterations;
+        result.seconds = std::chrono::duration<double>(stop - start).count();
+        result.megabytes_per_second = (static_cast<double>(result.bytes) * iterations / 1e6)
+                                      / result.seconds;
+        result.items_per_second = total_items / result.seconds;
+        result.allocations_per_item = static_cast<double>(allocations) / total_items;
+        return result;
+    }
+
+    template<typename Wrapper>
+    BenchResult measureParse(const QString &name,
+                             const std::vector<QByteArray> &payloads,
+                             size_t items,
+                             int iterations)
+    {
+        // Parse everything once to warm up and make sure the payloads are valid.
+        for (const auto &payload : payloads) {
+            Wrapper wrapper;
+            if (!json::parse_into<JSON_MODE>(wrapper, payload)) {
+                spdlog::error("bench: a {} payload failed to parse", name);
+                return BenchResult{.name = name};
+            }
+        }
+        return measure(name, payloads, items, iterations, [&payloads]() {
+            for (const auto &payload : payloads) {
+                Wrapper wrapper;
+                json::parse_into<JSON_MODE>(wrapper, payload);
+            }
+        });
+    }
+
+    // Compares reading and writing JSON against BEVE for the same objects. The
+    // binary form is also checked to survive a round trip unchanged.
+    template<typename Wrapper>
+    void measureCodecs(const QString &name,
+                       const std::vector<QByteArray> &payloads,
+                       size_t items,
+                       int iterations,
+                       std::vector<BenchResult> &results)
+    {
+        std::vector<Wrapper> objects(payloads.size());
+        std::vector<QByteArray> binaries;
+        for (size_t i = 0; i < payloads.size(); ++i) {
+            json::parse_into<JSON_MODE>(objects[i], payloads[i]);
+            binaries.push_back(json::toBinary(objects[i]));
+
+            Wrapper copy;
+            if (!json::parse_binary_into(copy, binaries.back())
+                || (json::toBinary(copy) != binaries.back())) {
+                spdlog::error("bench: a {} payload did not survive a beve round trip", name);
+                return;
+            }
+        }
+
+        results.push_back(measure(name + " json write", payloads, items, iterations, [&]() {
+            for (const auto &object : objects) {
+                json::toByteArray(object);
+            }
+        }));
+        results.push_back(measure(name + " beve write", binaries, items, iterations, [&]() {
+            for (const auto &object : objects) {
+                json::toBinary(object);
+            }
+        }));
+        results.push_back(measure(name + " beve read", binaries, items, iterations, [&]() {
+            for (const auto &binary : binaries) {
+                Wrapper wrapper;
+                json::parse_binary_into(wrapper, binary);
+            }
+        }));
+    }
+
+    // Builds a large item tree and measures the memory it holds for each item,
+    // then reads every cell of it one stash at a time, including the parent
+    // lookups that a view makes for each index it paints. Finally it sorts the
+    // tree the way clicking a column header does, alternating the order so
+    // that every iteration has to move the rows, and runs saved searches.
+    void measureTree(bench::PayloadGenerator &generator,
+                     int item_count,
+                     int iterations,
+                     std::vector<BenchResult> &results)
+    {
+        constexpr int ITEMS_PER_STASH = 250;
+
+        // The stashes are released once the model has built the tree from
+        // them, so whatever is still allocated at the end belongs to the tree.
+        const size_t bytes_before = bench::allocatedBytes();
+        std::vector<poe::StashTab> tabs;
+        size_t items = 0;
+        for (int added = 0; added < item_count; added += ITEMS_PER_STASH) {
+            tabs.push_back(generator.stash(std::min(ITEMS_PER_STASH, item_count - added)));
+            items += bench::PayloadGenerator::countItems(tabs.back().items.value());
+        }
+        const int stash_count = static_cast<int>(tabs.size());
+
+        // The model builds the tree on another thread.
+        TreeModel model;
+        model.addStashes(std::move(tabs));
+        const QModelIndex stashes = model.index(1, 0);
+        while (model.rowCount(stashes) < stash_count) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        const size_t bytes = bench::allocatedBytes() - bytes_before;
+        results.push_back(BenchResult{.name = "item tree memory",
+                                      .items = items,
+                                      .bytes_per_item = static_cast<double>(bytes) / items});
+
+        const int columns = model.columnCount();
+        results.push_back(measure("item tree scroll", {}, items, iterations, [&]() {
+            for (int i = 0; i < model.rowCount(stashes); ++i) {
+                const QModelIndex stash = model.index(i, 0, stashes);
+                for (int row = 0; row < model.rowCount(stash); ++row) {
+                    for (int column = 0; column < columns; ++column) {
+                        const QModelIndex index = model.index(row, column, stash);
+                        model.data(index);
+                        model.parent(index);
+                    }
+                }
+            }
+        }));
+
+        SortFilterModel proxy(model);
+        const auto measureSort = [&](const QString &name, int column) {
+            Qt::SortOrder order = Qt::AscendingOrder;
+            results.push_back(measure(name, {}, items, iterations, [&]() {
+                proxy.sort(column, order);
+                order = (order == Qt::AscendingOrder) ? Qt::DescendingOrder : Qt::AscendingOrder;
+            }));
+        };
+        measureSort("item tree sort text", 0); // Name
+        measureSort("item tree sort number", 11); // Total DPS
+
+        // Saved searches are run together, the way a shop refresh runs them.
+        constexpr int SAVED_SEARCHES = 200;
+        const std::array<QString, 5> queries = {
+            "rare ilvl>=%1 mod:life mod:resistance>=2",
+            "(dps>%1 or pdps>%1) not corrupted",
+            "mod:\"maximum energy shield\" es>=%1",
+            "unique ilvl>%1 or gem level>=%1",
+            "links>=5 and level<%1",
+        };
+        std::vector<ItemFilter> filters(SAVED_SEARCHES);
+        for (int i = 0; i < SAVED_SEARCHES; ++i) {
+            const QString query = queries[i % queries.size()].arg(60 + i / 8);
+            if (!filters[i].compile(query)) {
+                spdlog::error("bench: '{}' did not compile: {}", query, filters[i].errorString());
+                return;
+            }
+        }
+        const auto name = QString("item filter %1 searches").arg(SAVED_SEARCHES);
+        results.push_back(measure(name, {}, items, iterations, [&]() {
+            ItemFilter::matchAll(filters, model.nodes(), *QThreadPool::globalInstance());
+        }));
+    }
+
+    int intOption(const QCommandLineParser &parser, const QString &name)
+    {
+        bool ok = false;
+        const int value = parser.value(name).toInt(&ok);
+        if (!ok || (value <= 0)) {
+            spdlog::error("bench: --{} must be a positive integer", name);
+            std::exit(EXIT_FAILURE);
+        }
+        return value;
+    }
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Parser benchmarks for acquisition");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"seed", "Seed for the payload generator.", "n", "1"},
+        {"iterations", "Number of times each payload is parsed.", "n", "20"},
+        {"stashes", "Number of stash payloads.", "n", "50"},
+        {"items", "Number of items in each stash payload.", "n", "60"},
+        {"characters", "Number of character payloads.", "n", "10"},
+        {"tree-items", "Number of items in the scrolled item tree.", "n", "50000"},
+        {"history", "Append the results to this JSON lines file.", "file"},
+    });
+    parser.process(app);
+
+    BenchRun run;
+    run.timestamp = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    run.compiler = ACQUISITION_BENCH_COMPILER;
+    run.seed = static_cast<unsigned>(intOption(parser, "seed"));
+    run.iterations = intOption(parser, "iterations");
+    run.counts_qt_allocations = bench::countsAllAllocations();
+
+    const int stash_count = intOption(parser, "stashes");
+    const int item_count = intOption(parser, "items");
+    const int character_count = intOption(parser, "characters");
+    const int tree_item_count = intOption(parser, "tree-items");
+
+    bench::PayloadGenerator generator(run.seed);
+
+    std::vector<QByteArray> stashes;
+    size_t stash_items = 0;
+    for (int i = 0; i < stash_count; ++i) {
+        const poe::StashWrapper wrapper{generator.stash(item_count)};
+        stash_items += bench::PayloadGenerator::countItems(wrapper.stash->items.value());
+        stashes.push_back(json::toByteArray(wrapper));
+    }
+
+    std::vector<QByteArray> characters;
+    size_t character_items = 0;
+    for (int i = 0; i < character_count; ++i) {
+        const poe::CharacterWrapper wrapper{generator.character(item_count)};
+        const auto &character = wrapper.character.value();
+        character_items += bench::PayloadGenerator::countItems(character.equipment.value());
+        character_items += bench::PayloadGenerator::countItems(character.inventory.value());
+        characters.push_back(json::toByteArray(wrapper));
+    }
+
+    const poe::StashListWrapper stash_list{generator.stashList(stash_count)};
+    const poe::CharacterListWrapper character_list{generator.characterList(character_count)};
+    const std::vector<QByteArray> stash_lists{json::toByteArray(stash_list)};
+    const std::vector<QByteArray> character_lists{json::toByteArray(character_list)};
+
+    run.results.push_back(
+        measureParse<poe::StashWrapper>("stash", stashes, stash_items, run.iterations));
+    run.results.push_back(measureParse<poe::CharacterWrapper>("character",
+                                                              characters,
+                                                              character_items,
+                                                              run.iterations));
+    run.results.push_back(measureParse<poe::StashListWrapper>("stash list",
+                                                              stash_lists,
+                                                              stash_list.stashes.size(),
+                                                              run.iterations));
+    run.results.push_back(measureParse<poe::CharacterListWrapper>("character list",
+                                                                  character_lists,
+                                                                  character_list.characters.size(),
+                                                                  run.iterations));
+
+    // Stashes are left out because their layout metadata is kept as raw JSON.
+    measureCodecs<poe::CharacterWrapper>("character",
+                                         characters,
+                                         character_items,
+                                         run.iterations,
+                                         run.results);
+
+    measureTree(generator, tree_item_count, run.iterations, run.results);
+
+    fmt::print("{:<24}{:>10}{:>12}{:>12}{:>14}{:>14}{:>14}\n",
+               "payload",
+               "count",
+               "bytes",
+               "MB/s",
+               "items/s",
+               "allocs/item",
+               "bytes/item");
+    for (const auto &result : run.results) {
+        fmt::print("{:<24}{:>10}{:>12}{:>12.1f}{:>14.0f}{:>14.1f}{:>14.0f}\n",
+                   result.name,
+                   result.payloads,
+                   result.bytes,
+                   result.megabytes_per_second,
+                   result.items_per_second,
+                   result.allocations_per_item,
+                   result.bytes_per_item);
+    }
+    if (!run.counts_qt_allocations) {
+        fmt::print("\nOnly operator new is counted here, so Qt's allocations are missing,");
+        fmt::print(" and memory is not measured.\n");
+    }
+
+    if (parser.isSet("history")) {
+        QFile file(parser.value("history"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            spdlog::error("bench: unable to open {}: {}", file.fileName(), file.errorString());
+            return EXIT_FAILURE;
+        }
+        file.write(json::toByteArray(run) + "\n");
+    }
+    return EXIT_SUCCESS;
+}
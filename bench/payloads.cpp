@@ -0,0 +1,528 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "payloads.h"
+
+namespace {
+
+    using Type = poe::ItemPropertyType;
+
+    const std::vector<QString> CURRENCY = {"Chaos Orb",
+                                           "Orb of Alteration",
+                                           "Orb of Fusing",
+                                           "Exalted Orb",
+                                           "Divine Orb",
+                                           "Jeweller's Orb",
+                                           "Orb of Scouring",
+                                           "Vaal Orb"};
+
+    const std::vector<QString> GEMS = {"Cyclone",
+                                       "Arc",
+                                       "Fireball",
+                                       "Added Fire Damage Support",
+                                       "Multistrike Support",
+                                       "Faster Attacks Support",
+                                       "Vaal Righteous Fire",
+                                       "Enlighten Support"};
+
+    const std::vector<QString> MAPS = {"Strand Map", "Cemetery Map", "Tower Map", "Dunes Map"};
+
+    const std::vector<QString> ARMOUR_BASES = {"Vaal Regalia",
+                                               "Astral Plate",
+                                               "Hubris Circlet",
+                                               "Two-Toned Boots",
+                                               "Sorcerer Gloves",
+                                               "Stygian Vise",
+                                               "Onyx Amulet",
+                                               "Diamond Ring"};
+
+    const std::vector<QString> WEAPON_BASES = {"Jewelled Foil",
+                                               "Vaal Axe",
+                                               "Imperial Bow",
+                                               "Harbinger Bow",
+                                               "Siege Axe",
+                                               "Ambusher"};
+
+    const std::vector<QString> UNIQUES = {"Headhunter",
+                                          "Mageblood",
+                                          "Shavronne's Wrappings",
+                                          "Kaom's Heart",
+                                          "The Taming",
+                                          "Tabula Rasa"};
+
+    const std::vector<QString> NAME_PARTS = {"Doom", "Storm", "Grim", "Havoc", "Rune", "Blood",
+                                             "Bane", "Loop", "Coil", "Fang", "Gyre", "Shroud"};
+
+    const std::vector<QString> IMPLICIT_MODS = {"+25 to maximum Life",
+                                                "+(20-30) to Strength and Intelligence",
+                                                "16% increased Elemental Damage",
+                                                "+0.3 metres to Weapon Range",
+                                                "Adds 1 to 4 Lightning Damage to Attacks"};
+
+    const std::vector<QString> EXPLICIT_MODS = {"+92 to maximum Life",
+                                                "+45% to Fire Resistance",
+                                                "+41% to Cold Resistance",
+                                                "+38% to Lightning Resistance",
+                                                "+13% to Chaos Resistance",
+                                                "+48 to Dexterity",
+                                                "30% increased Movement Speed",
+                                                "112% increased Energy Shield",
+                                                "+87 to maximum Energy Shield",
+                                                "Adds 22 to 41 Physical Damage",
+                                                "179% increased Physical Damage",
+                                                "+25% to Global Critical Strike Multiplier",
+                                                "12% increased Attack Speed",
+                                                "Regenerate 1.6% of Life per second"};
+
+    const std::vector<QString> CRAFTED_MODS = {"+(10-12)% to Fire and Chaos Resistances",
+                                               "Adds 16 to 28 Physical Damage",
+                                               "+68 to maximum Mana",
+                                               "Prefixes Cannot Be Changed"};
+
+    const std::vector<QString> FLAVOUR = {"Do what you will, but harm none.",
+                                          "A mind unbound;\r",
+                                          "the chaos of the void is yours to command.",
+                                          "Many have died for this one."};
+
+    const std::vector<QString> SOCKET_COLOURS = {"R", "G", "B", "W", "A"};
+    const std::vector<QString> SOCKET_ATTRIBUTES = {"S", "D", "I", "G", "A"};
+
+    const std::vector<QString> STASH_TYPES = {"NormalStash",
+                                              "PremiumStash",
+                                              "QuadStash",
+                                              "CurrencyStash",
+                                              "MapStash",
+                                              "Folder"};
+
+    const std::vector<QString> CLASSES = {"Necromancer", "Juggernaut", "Deadeye", "Occultist"};
+
+    const std::vector<QString> INVENTORY_IDS = {"Helm", "BodyArmour", "Gloves", "Boots",
+                                                "Weapon", "Offhand", "Ring", "Amulet"};
+
+    poe::ItemProperty property(const QString &name,
+                               const QString &value,
+                               Type type,
+                               int value_type = 0)
+    {
+        return poe::ItemProperty{.name = name,
+                                 .values = {{value, value_type}},
+                                 .displayMode = poe::DisplayMode::NameFirst,
+                                 .type = type};
+    }
+
+    poe::ItemProperty label(const QString &name)
+    {
+        return poe::ItemProperty{.name = name, .displayMode = poe::DisplayMode::NameFirst};
+    }
+
+} // namespace
+
+bench::PayloadGenerator::PayloadGenerator(unsigned seed)
+    : m_random(seed)
+{}
+
+poe::StashTab bench::PayloadGenerator::stash(int item_count)
+{
+    poe::StashTab stash{};
+    stash.id = hexId(10);
+    stash.name = "Dump " + QString::number(uniform(1, 99));
+    stash.type = pick(STASH_TYPES);
+    stash.index = static_cast<unsigned>(uniform(0, 80));
+    stash.metadata.colour = hexId(6);
+    stash.metadata.layout.str = "{}";
+
+    m_position = 0;
+    std::vector<poe::Item> items;
+    items.reserve(static_cast<size_t>(item_count));
+    for (int i = 0; i < item_count; ++i) {
+        items.push_back(item());
+        items.back().inventoryId = "Stash" + QString::number(stash.index.value() + 1);
+    }
+    stash.items = std::move(items);
+    return stash;
+}
+
+poe::Character bench::PayloadGenerator::character(int item_count)
+{
+    poe::Character character{};
+    character.id = hexId(64);
+    character.name = pick(NAME_PARTS) + pick(NAME_PARTS) + QString::number(uniform(1, 999));
+    character.realm = "pc";
+    character.class_ = pick(CLASSES);
+    character.league = "Standard";
+    character.level = static_cast<unsigned>(uniform(1, 100));
+    character.experience = static_cast<unsigned>(uniform(0, 2000000000));
+
+    // Equipment is always gear, and the rest goes into the main inventory.
+    m_position = 0;
+    std::vector<poe::Item> equipment;
+    for (const auto &slot : INVENTORY_IDS) {
+        equipment.push_back((slot == "Weapon") ? weapon() : gear());
+        equipment.back().inventoryId = slot;
+    }
+    std::vector<poe::Item> inventory;
+    for (int i = static_cast<int>(equipment.size()); i < item_count; ++i) {
+        inventory.push_back(item());
+        inventory.back().inventoryId = "MainInventory";
+    }
+    character.equipment = std::move(equipment);
+    character.inventory = std::move(inventory);
+    return character;
+}
+
+std::vector<poe::StashTab> bench::PayloadGenerator::stashList(int stash_count)
+{
+    std::vector<poe::StashTab> stashes;
+    for (int i = 0; i < stash_count; ++i) {
+        poe::StashTab stash{};
+        stash.id = hexId(10);
+        stash.name = pick(NAME_PARTS) + " " + QString::number(i);
+        stash.type = pick(STASH_TYPES);
+        stash.index = static_cast<unsigned>(i);
+        stash.metadata.colour = hexId(6);
+        stash.metadata.layout.str = "{}";
+        if (stash.type == "Folder") {
+            stash.metadata.folder = true;
+            std::vector<poe::StashTab> children;
+            for (int k = 0; k < uniform(1, 4); ++k) {
+                poe::StashTab child{};
+                child.id = hexId(10);
+                child.parent = stash.id;
+                child.folder = stash.id;
+                child.name = pick(NAME_PARTS);
+                child.type = "PremiumStash";
+                child.metadata.colour = hexId(6);
+                child.metadata.layout.str = "{}";
+                children.push_back(std::move(child));
+            }
+            stash.children = std::move(children);
+        }
+        stashes.push_back(std::move(stash));
+    }
+    return stashes;
+}
+
+std::vector<poe::Character> bench::PayloadGenerator::characterList(int character_count)
+{
+    std::vector<poe::Character> characters;
+    for (int i = 0; i < character_count; ++i) {
+        poe::Character character{};
+        character.id = hexId(64);
+        character.name = pick(NAME_PARTS) + pick(NAME_PARTS) + QString::number(i);
+        character.realm = "pc";
+        character.class_ = pick(CLASSES);
+        character.league = chance(0.5) ? "Standard" : "Hardcore";
+        character.level = static_cast<unsigned>(uniform(1, 100));
+        character.experience = static_cast<unsigned>(uniform(0, 2000000000));
+        if (chance(0.2)) {
+            character.expired = true;
+        }
+        characters.push_back(std::move(character));
+    }
+    return characters;
+}
+
+size_t bench::PayloadGenerator::countItems(const std::vector<poe::Item> &items)
+{
+    size_t count = items.size();
+    for (const auto &item : items) {
+        if (item.socketedItems) {
+            count += countItems(item.socketedItems.value());
+        }
+    }
+    return count;
+}
+
+poe::Item bench::PayloadGenerator::item()
+{
+    // Roughly the mix of a well-used dump tab.
+    const int roll = uniform(0, 99);
+    poe::Item item = (roll < 30)   ? currency()
+                     : (roll < 42) ? gem()
+                     : (roll < 52) ? map()
+                     : (roll < 80) ? gear()
+                     : (roll < 92) ? weapon()
+                                   : unique();
+
+    item.x = m_position % 12;
+    item.y = (m_position / 12) % 12;
+    ++m_position;
+    return item;
+}
+
+poe::Item bench::PayloadGenerator::currency()
+{
+    const int stack = uniform(1, 20);
+    const QString base = pick(CURRENCY);
+
+    poe::Item item{};
+    item.verified = false;
+    item.w = 1;
+    item.h = 1;
+    item.icon = "https://web.poecdn.com/gen/image/" + hexId(32) + "/" + base + ".png";
+    item.stackSize = stack;
+    item.maxStackSize = 20;
+    item.id = hexId(64);
+    item.typeLine = base;
+    item.baseType = base;
+    item.identified = true;
+    item.ilvl = 0;
+    item.properties = std::vector{
+        property("Stack Size", QString("%1/20").arg(stack), Type::StackSize)};
+    item.explicitMods = std::vector<QString>{"Reforges a rare item with new random modifiers"};
+    item.descrText = "Right click this item then left click a rare item to apply it.";
+    item.frameType = poe::FrameType::Currency;
+    return item;
+}
+
+poe::Item bench::PayloadGenerator::gem()
+{
+    const QString base = pick(GEMS);
+    const int level = uniform(1, 21);
+    const int quality = uniform(0, 23);
+
+    poe::Item item{};
+    item.verified = false;
+    item.w = 1;
+    item.h = 1;
+    item.icon = "https://web.poecdn.com/gen/image/" + hexId(32) + "/" + base + ".png";
+    item.support = base.endsWith("Support") ? std::optional(true) : std::nullopt;
+    item.id = hexId(64);
+    item.typeLine = base;
+    item.baseType = base;
+    item.identified = true;
+    item.ilvl = 0;
+    item.corrupted = chance(0.2) ? std::optional(true) : std::nullopt;
+    item.properties = std::vector{
+        label("Attack, AoE, Melee"),
+        property("Level", QString::number(level), Type::Level),
+        property("Quality", QString("+%1%").arg(quality), Type::Quality, 1)};
+    addRequirements(item, std::min(72, 10 + 3 * level));
+    item.secDescrText = "Perform a spinning series of attacks as you travel to a target location.";
+    item.explicitMods = mods(EXPLICIT_MODS, 3);
+    item.descrText = "Place into an item socket of the right colour to gain this skill.";
+    item.frameType = poe::FrameType::Gem;
+    if (base.startsWith("Vaal")) {
+        item.hybrid = poe::Item::HybridInfo{.isVaalGem = true,
+                                            .baseTypeName = base.sliced(5),
+                                            .explicitMods = mods(EXPLICIT_MODS, 2),
+                                            .secDescrText = "Burns and weakens enemies."};
+    }
+    return item;
+}
+
+poe::Item bench::PayloadGenerator::map()
+{
+    const QString base = pick(MAPS);
+    const int tier = uniform(1, 16);
+
+    poe::Item item{};
+    item.verified = false;
+    item.w = 1;
+    item.h = 1;
+    item.icon = "https://web.poecdn.com/gen/image/" + hexId(32) + "/Map.png";
+    item.id = hexId(64);
+    item.typeLine = base;
+    item.baseType = base;
+    item.identified = true;
+    item.ilvl = 67 + tier;
+    item.properties = std::vector{property("Map Tier", QString::number(tier), Type::MapTier),
+                                  property("Item Quantity", "+37%", Type::ItemQuantity, 1),
+                                  property("Item Rarity", "+21%", Type::ItemRarity, 1)};
+    item.explicitMods = mods(EXPLICIT_MODS, uniform(0, 6));
+    item.descrText = "Travel to this Map by using it in a personal Map Device.";
+    item.frameType = item.explicitMods->empty() ? poe::FrameType::Normal : poe::FrameType::Rare;
+    return item;
+}
+
+poe::Item bench::PayloadGenerator::gear()
+{
+    const QString base = pick(ARMOUR_BASES);
+
+    poe::Item item{};
+    item.verified = false;
+    item.w = 2;
+    item.h = uniform(1, 3);
+    item.icon = "https://web.poecdn.com/gen/image/" + hexId(32) + "/" + base + ".png";
+    item.id = hexId(64);
+    item.name = pick(NAME_PARTS) + " " + pick(NAME_PARTS);
+    item.typeLine = base;
+    item.baseType = base;
+    item.identified = true;
+    item.ilvl = uniform(60, 86);
+    item.properties = std::vector{
+        property("Quality", "+20%", Type::Quality, 1),
+        property("Armour", QString::number(uniform(100, 2000)), Type::Armour),
+        property("Energy Shield", QString::number(uniform(20, 700)), Type::EnergyShield)};
+    addRequirements(item, uniform(40, 84));
+    item.implicitMods = mods(IMPLICIT_MODS, uniform(0, 2));
+    item.explicitMods = mods(EXPLICIT_MODS, uniform(3, 6));
+    if (chance(0.3)) {
+        item.craftedMods = mods(CRAFTED_MODS, 1);
+    }
+    if (chance(0.1)) {
+        item.fracturedMods = mods(EXPLICIT_MODS, 1);
+        item.fractured = true;
+    }
+    if (chance(0.15)) {
+        item.influences = poe::Item::Influences{.shaper = true};
+        item.shaper = true;
+    }
+    addSockets(item, 6);
+    item.frameType = poe::FrameType::Rare;
+    return item;
+}
+
+poe::Item bench::PayloadGenerator::weapon()
+{
+    poe::Item item = gear();
+    const QString base = pick(WEAPON_BASES);
+    item.typeLine = base;
+    item.baseType = base;
+    item.h = 4;
+    const QString damage = QString("%1-%2").arg(uniform(50, 150)).arg(uniform(200, 450));
+    item.properties = std::vector{
+        label("Two Handed Axe"),
+        property("Quality", "+20%", Type::Quality, 1),
+        property("Physical Damage", damage, Type::PhysicalDamage, 1),
+        property("Critical Strike Chance", "5.00%", Type::CriticalStrikeChance),
+        property("Attacks per Second", "1.45", Type::AttacksPerSecond, 1),
+        property("Weapon Range", "1.3 metres", Type::WeaponRange)};
+    if (chance(0.25)) {
+        addCrucible(item);
+    }
+    return item;
+}
+
+poe::Item bench::PayloadGenerator::unique()
+{
+    poe::Item item = gear();
+    item.name = pick(UNIQUES);
+    item.frameType = poe::FrameType::Unique;
+    item.craftedMods.reset();
+    item.flavourText = mods(FLAVOUR, 2);
+
+    // flavourTextParsed is usually a list of strings, but some
+    // uniques mix in objects that refer to other text.
+    std::vector<poe::Item::FlavourTextItem> parsed;
+    for (const auto &line : item.flavourText.value()) {
+        parsed.emplace_back(line.toStdString());
+    }
+    if (chance(0.3)) {
+        parsed.emplace_back(poe::Item::FlavorTextObject{.id = hexId(8),
+                                                        .type = "ItemFlavourText",
+                                                        .class_ = "uniqueflavourtext"});
+    }
+    item.flavourTextParsed = std::move(parsed);
+    if (chance(0.1)) {
+        item.foilVariation = uniform(1, 12);
+        item.isRelic = true;
+    }
+    return item;
+}
+
+void bench::PayloadGenerator::addSockets(poe::Item &item, int max_sockets)
+{
+    const int count = uniform(0, max_sockets);
+    if (count == 0) {
+        return;
+    }
+    std::vector<poe::ItemSocket> sockets;
+    std::vector<poe::Item> socketed;
+    unsigned group = 0;
+    for (int i = 0; i < count; ++i) {
+        if ((i > 0) && chance(0.3)) {
+            ++group;
+        }
+        const int colour = uniform(0, static_cast<int>(SOCKET_COLOURS.size()) - 1);
+        sockets.push_back({group,
+                           SOCKET_ATTRIBUTES[static_cast<size_t>(colour)],
+                           SOCKET_COLOURS[static_cast<size_t>(colour)]});
+        if (chance(0.4)) {
+            socketed.push_back(gem());
+            socketed.back().socket = static_cast<unsigned>(i);
+        }
+    }
+    item.sockets = std::move(sockets);
+    if (!socketed.empty()) {
+        item.socketedItems = std::move(socketed);
+    }
+}
+
+void bench::PayloadGenerator::addCrucible(poe::Item &item)
+{
+    // The tree is sent as a list for some items and a map keyed by node index for others.
+    const int node_count = uniform(5, 20);
+    poe::Item::CrucibleNodeList list;
+    for (int i = 0; i < node_count; ++i) {
+        poe::CrucibleNode node{};
+        node.skill = static_cast<unsigned>(uniform(1000, 99999));
+        node.tier = static_cast<unsigned>(uniform(1, 5));
+        node.icon = "https://web.poecdn.com/gen/image/" + hexId(32) + "/Crucible.png";
+        if (chance(0.4)) {
+            node.allocated = true;
+        }
+        node.stats = mods(EXPLICIT_MODS, 1);
+        node.orbit = static_cast<unsigned>(i / 3);
+        node.orbitIndex = static_cast<unsigned>(i % 3);
+        if (i + 3 < node_count) {
+            node.out.push_back(QString::number(i + 3));
+        }
+        if (i >= 3) {
+            node.in.push_back(QString::number(i - 3));
+        }
+        list.push_back(std::move(node));
+    }
+
+    poe::Item::CrucibleInfo crucible{};
+    crucible.layout = "https://web.poecdn.com/image/crucible/" + hexId(16) + ".png";
+    if (chance(0.5)) {
+        crucible.nodes = std::move(list);
+    } else {
+        poe::Item::CrucibleNodeMap map;
+        for (size_t i = 0; i < list.size(); ++i) {
+            map.emplace(QString::number(i), std::move(list[i]));
+        }
+        crucible.nodes = std::move(map);
+    }
+    item.crucible = std::move(crucible);
+    item.crucibleMods = mods(EXPLICIT_MODS, 2);
+}
+
+void bench::PayloadGenerator::addRequirements(poe::Item &item, int level)
+{
+    item.requirements = std::vector{
+        property("Level", QString::number(level), Type::RequiredLevel),
+        property("Str", QString::number(uniform(0, 155)), Type::RequiredStrength),
+        property("Int", QString::number(uniform(0, 155)), Type::RequiredIntelligence)};
+}
+
+std::vector<QString> bench::PayloadGenerator::mods(const std::vector<QString> &pool, int count)
+{
+    std::vector<QString> result;
+    result.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        result.push_back(pick(pool));
+    }
+    return result;
+}
+
+int bench::PayloadGenerator::uniform(int low, int high)
+{
+    return std::uniform_int_distribution<int>(low, high)(m_random);
+}
+
+bool bench::PayloadGenerator::chance(double probability)
+{
+    return std::bernoulli_distribution(probability)(m_random);
+}
+
+QString bench::PayloadGenerator::hexId(int digits)
+{
+    static constexpr char HEX[] = "0123456789abcdef";
+    QString id(digits, Qt::Uninitialized);
+    for (int i = 0; i < digits; ++i) {
+        id[i] = QLatin1Char(HEX[uniform(0, 15)]);
+    }
+    return id;
+}
@@ -0,0 +1,65 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "poe/types/character.h"
+#include "poe/types/item.h"
+#include "poe/types/stashtab.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <random>
+#include <vector>
+
+namespace bench {
+
+    // Builds synthetic API payloads that look like the ones the game servers send.
+    //
+    // Items are drawn from a mix of currency, gems, maps, rare gear, weapons and
+    // uniques, with sockets, socketed gems, crucible trees, and both forms of
+    // flavourTextParsed. The same seed always produces the same payloads, so
+    // results from different builds can be compared.
+    class PayloadGenerator
+    {
+    public:
+        explicit PayloadGenerator(unsigned seed);
+
+        poe::StashTab stash(int item_count);
+        poe::Character character(int item_count);
+        std::vector<poe::StashTab> stashList(int stash_count);
+        std::vector<poe::Character> characterList(int character_count);
+
+        // Counts items including socketed items, which glaze parses the same way.
+        static size_t countItems(const std::vector<poe::Item> &items);
+
+    private:
+        poe::Item item();
+        poe::Item currency();
+        poe::Item gem();
+        poe::Item map();
+        poe::Item gear();
+        poe::Item weapon();
+        poe::Item unique();
+
+        void addSockets(poe::Item &item, int max_sockets);
+        void addCrucible(poe::Item &item);
+        void addRequirements(poe::Item &item, int level);
+        std::vector<QString> mods(const std::vector<QString> &pool, int count);
+
+        int uniform(int low, int high);
+        bool chance(double probability);
+        QString hexId(int digits);
+
+        template<typename T>
+        const T &pick(const std::vector<T> &values)
+        {
+            return values[static_cast<size_t>(uniform(0, static_cast<int>(values.size()) - 1))];
+        }
+
+        std::mt19937 m_random;
+        unsigned m_position{0};
+    };
+
+} // namespace bench
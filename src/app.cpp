@@ -3,6 +3,7 @@
 
 #include "app.h"
 
+#include "model/itemfilter.h"
 #include "util/json.h"
 #include "util/qt.h"
 #include "util/spdlog_qt.h"
@@ -15,7 +16,8 @@ App::App(QObject *parent)
     : QObject{parent}
     , m_oauthManager{m_networkManager}
     , m_rateLimiter{m_networkManager}
-    , m_itemSelectionModel{&m_itemModel}
+    , m_itemSortFilterModel{m_itemModel}
+    , m_itemSelectionModel{&m_itemSortFilterModel}
 {
     connect(&m_oauthManager, &OAuthManager::grantAccess, this, &App::accessGranted);
     connect(&m_rateLimiter, &RateLimiter::Paused, this, &App::rateLimited);
@@ -96,6 +98,26 @@ void App::loadItems(const QString &realm, const QString &league)
     m_clientStore->loadStashes(realm, league);
 }
 
+QStringList App::searchItems(const QString &text, int limit) const
+{
+    if (!m_clientStore) {
+        spdlog::error("App: cannot search items: repo is uninitialized.");
+        return {};
+    }
+    return m_clientStore->searchItems(text, limit);
+}
+
+bool App::filterItems(const QString &query)
+{
+    ItemFilter filter;
+    if (!filter.compile(query)) {
+        spdlog::debug("App: invalid item filter '{}': {}", query, filter.errorString());
+        return false;
+    }
+    m_itemSortFilterModel.setFilter(std::move(filter));
+    return true;
+}
+
 QStringList App::getCharacterNames() const
 {
     spdlog::debug("App: getting character names");
@@ -192,7 +214,7 @@ void App::getAllStashes()
 void App::accessGranted(const OAuthToken &token)
 {
     // Store the token and username
-    m_globalStore.set("oauth_token", json::toString(token));
+    m_globalStore.store("oauth_token", token);
     m_globalStore.set("last_username", token.username);
 
     // Update ourselves.
@@ -205,6 +227,8 @@ void App::accessGranted(const OAuthToken &token)
     auto *client = m_clientStore.get();
     connect(client, &UserStore::characterReady, &m_itemModel, &TreeModel::addCharacter);
     connect(client, &UserStore::stashReady, &m_itemModel, &TreeModel::addStash);
+    connect(client, &UserStore::charactersReady, &m_itemModel, &TreeModel::addCharacters);
+    connect(client, &UserStore::stashesReady, &m_itemModel, &TreeModel::addStashes);
 
     QSqlDatabase db = m_clientStore->getDatabase();
     m_characterTableModel.setQuery("SELECT name, realm, league, timestamp FROM characters", db);
@@ -254,17 +278,10 @@ void App::selectionChanged(const QModelIndex &current, const QModelIndex &previo
         return;
     }
 
-    const auto node = m_itemModel.getNode(current);
-
-    if (!node) {
-        spdlog::warn("App: the selection changed but the node is invalid.");
-        return;
-    }
-
-    if (node->isItem()) {
-        const auto &payload = node->payload();
-        const auto &item = std::get<ItemData>(payload);
-        m_tooltip = std::make_unique<ItemTooltip>(item);
+    const ItemData *item = m_itemSortFilterModel.getItem(current);
+    if (item) {
+        const auto details = m_itemSortFilterModel.getDetails(current);
+        m_tooltip = std::make_unique<ItemTooltip>(*item, details);
         emit tooltipChanged();
     }
 }
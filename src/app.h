@@ -11,6 +11,7 @@
 
 #include "datastore/globalstore.h"
 #include "datastore/userstore.h"
+#include "model/sortfiltermodel.h"
 #include "model/treemodel.h"
 #include "ratelimit/ratelimiter.h"
 
@@ -67,6 +68,11 @@ public:
     Q_INVOKABLE QStringList getRealmNames() const;
     Q_INVOKABLE QStringList getLeagueNames(const QString &realm) const;
     Q_INVOKABLE void loadItems(const QString &realm, const QString &league);
+    Q_INVOKABLE QStringList searchItems(const QString &text, int limit = 100) const;
+
+    // Shows only the items that match a query, or every item if it is empty.
+    // Returns false and leaves the current filter alone if the query is invalid.
+    Q_INVOKABLE bool filterItems(const QString &query);
 
     QStringList getCharacterNames() const;
     QStringList getStashNames() const;
@@ -75,7 +81,7 @@ public:
     QItemSelectionModel *getItemSelectionModel() { return &m_itemSelectionModel; }
     QSqlQueryModel *getCharacterModel() { return &m_characterTableModel; }
     QSqlQueryModel *getStashModel() { return &m_stashTableModel; }
-    QAbstractItemModel *getItemModel() { return &m_itemModel; }
+    QAbstractItemModel *getItemModel() { return &m_itemSortFilterModel; }
 
     ItemTooltip *getItemTooltip() { return m_tooltip.get(); }
 
@@ -116,6 +122,7 @@ private:
     std::unique_ptr<UserStore> m_clientStore;
 
     TreeModel m_itemModel;
+    SortFilterModel m_itemSortFilterModel;
     QItemSelectionModel m_itemSelectionModel;
     std::unique_ptr<ItemTooltip> m_tooltip;
 
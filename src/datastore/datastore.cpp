@@ -3,27 +3,49 @@
 
 #include "datastore.h"
 
+#include "datastore/sqlquery.h"
 #include "util/spdlog_qt.h"
 
 static_assert(ACQUISITION_USE_SPDLOG); // Prevents unused header warnings in Qt Creator.
 
+#include <QDateTime>
 #include <QFileInfo>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QThread>
 
+#include <algorithm>
+
 DataStore::DataStore(const QString &filename, QObject *parent)
     : QObject(parent)
     , m_filename(filename)
-{}
+    , m_readPool(std::make_unique<QThreadPool>())
+    , m_backgroundPool(std::make_unique<QThreadPool>())
+{
+    // Idle readers expire after the default timeout, which also
+    // closes the connections they were using.
+    m_readPool->setMaxThreadCount(std::max(2, QThread::idealThreadCount()));
+    m_readPool->setObjectName("DataStoreReaders");
+
+    // Background writes are serialized.
+    m_backgroundPool->setMaxThreadCount(1);
+    m_backgroundPool->setObjectName("DataStoreBackground");
+}
 
 DataStore::~DataStore()
 {
+    // Deleting the pools joins their threads, which removes their
+    // connections before we clean up whatever is left.
+    stopBackgroundWork();
+    m_backgroundPool.reset();
+    m_readPool.reset();
+
     QMutexLocker locker(&m_mutex);
     const auto &connections = m_connections;
     for (const QString &connection : connections) {
         if (QSqlDatabase::contains(connection)) {
             spdlog::info("DataStore: removing {}", connection);
+            sql::releaseStatements(connection);
             QSqlDatabase::database(connection, false).close();
             QSqlDatabase::removeDatabase(connection);
         }
@@ -31,46 +53,97 @@ DataStore::~DataStore()
     m_connections.clear();
 }
 
-QString DataStore::getThreadLocalConnectionName() const
+QString DataStore::getThreadLocalConnectionName(const char *prefix) const
 {
     const QString file_name = QFileInfo(m_filename).fileName();
     const quintptr thread_id = reinterpret_cast<quintptr>(QThread::currentThread());
-    return QString("sqlite-%1-%2").arg(file_name).arg(thread_id);
+    return QString("%1-%2-%3").arg(prefix, file_name).arg(thread_id);
 }
 
 QSqlDatabase DataStore::getThreadLocalDatabase()
 {
-    QString connection = getThreadLocalConnectionName();
+    const QString connection = getThreadLocalConnectionName("sqlite");
+    if (QSqlDatabase::contains(connection)) {
+        return QSqlDatabase::database(connection);
+    }
+    return openDatabase(connection, false);
+}
+
+QSqlDatabase DataStore::getReadDatabase()
+{
+    const QString connection = getThreadLocalConnectionName("sqlite-read");
+    if (QSqlDatabase::contains(connection)) {
+        return QSqlDatabase::database(connection);
+    }
+    return openDatabase(connection, true);
+}
+
+QSqlDatabase DataStore::openDatabase(const QString &connection, bool read_only)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+    db.setDatabaseName(m_filename);
+    if (read_only) {
+        db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    }
 
-    // Create a new database connection if needed.
-    if (!QSqlDatabase::contains(connection)) {
-        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
-        db.setDatabaseName(m_filename);
+    // Open the databse.
+    if (!db.open()) {
+        const QString message = db.lastError().text();
+        spdlog::error("DataStore: failed to open database {}: {}", m_filename, message);
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connection);
+        return QSqlDatabase();
+    };
 
-        // Open the databse.
-        if (!db.open()) {
-            const QString message = db.lastError().text();
-            spdlog::error("DataStore: failed to open database {}: {}", m_filename, message);
-            return QSqlDatabase();
-        };
+    QSqlQuery query(db);
 
-        // Enable foreign keys.
-        QSqlQuery query(db);
-        if (!query.exec("PRAGMA foreign_keys = ON")) {
+    // Write-ahead logging lets readers run while another connection is writing.
+    if (!read_only) {
+        if (!query.exec("PRAGMA journal_mode = WAL")) {
             const QString message = query.lastError().text();
-            spdlog::warn("DataStore: failed to enable foreign keys on {}: {}", m_filename, message);
+            spdlog::warn("DataStore: failed to enable WAL on {}: {}", m_filename, message);
         }
+    }
 
-        // Save this connection for later.
+    // Enable foreign keys.
+    if (!query.exec("PRAGMA foreign_keys = ON")) {
+        const QString message = query.lastError().text();
+        spdlog::warn("DataStore: failed to enable foreign keys on {}: {}", m_filename, message);
+    }
+    query.finish();
+
+    // Save this connection for later.
+    {
         QMutexLocker locker(&m_mutex);
         m_connections.insert(connection);
     }
 
-    // Return this connection.
-    return QSqlDatabase::database(connection);
+    // Remove the connection when its thread exits, so that short-lived threads
+    // don't leave connections behind, and a new thread that happens to reuse
+    // the same address doesn't inherit a connection it doesn't own.
+    QThread *thread = QThread::currentThread();
+    connect(
+        thread,
+        &QThread::finished,
+        this,
+        [this, connection]() { removeConnection(connection); },
+        Qt::DirectConnection);
+
+    return db;
 }
 
-void DataStore::createTable(const QString &table, const QStringList &columns)
+void DataStore::removeConnection(const QString &connection)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_connections.remove(connection) && QSqlDatabase::contains(connection)) {
+        spdlog::debug("DataStore: removing {}", connection);
+        sql::releaseStatements(connection);
+        QSqlDatabase::database(connection, false).close();
+        QSqlDatabase::removeDatabase(connection);
+    }
+}
+
+bool DataStore::createTable(const QString &table, const QStringList &columns)
 {
     const QString cols = columns.join(", ");
     const QString stmt = QString("CREATE TABLE IF NOT EXISTS %1 (%2)").arg(table, cols);
@@ -82,13 +155,16 @@ void DataStore::createTable(const QString &table, const QStringList &columns)
     if (!query.exec()) {
         const QString message = query.lastError().text();
         spdlog::error("DataStore: failed to create {}: {}", table, message);
+        return false;
     }
+    return true;
 }
 
-void DataStore::createIndexes(const QString &table, const QStringList &columns)
+bool DataStore::createIndexes(const QString &table, const QStringList &columns)
 {
     auto db = getThreadLocalDatabase();
     auto query = QSqlQuery(db);
+    bool ok = true;
 
     for (const auto &column : columns) {
         const QString index = QString("idx_%1_%2").arg(table, column);
@@ -100,7 +176,244 @@ void DataStore::createIndexes(const QString &table, const QStringList &columns)
                           table,
                           column,
                           message);
+            ok = false;
             continue;
         }
     }
+    return ok;
+}
+
+bool DataStore::createFullTextTable(const QString &table, const QStringList &columns)
+{
+    // Prefix indexes for two and three characters keep short prefix queries
+    // from scanning the whole term list.
+    const QString cols = columns.join(", ");
+    const QString stmt = QString("CREATE VIRTUAL TABLE IF NOT EXISTS %1 USING fts5(%2,"
+                                 " tokenize = 'unicode61 remove_diacritics 2',"
+                                 " prefix = '2 3')")
+                             .arg(table, cols);
+
+    auto db = getThreadLocalDatabase();
+    auto query = QSqlQuery(db);
+    query.prepare(stmt);
+
+    if (!query.exec()) {
+        const QString message = query.lastError().text();
+        spdlog::error("DataStore: failed to create full-text table {}: {}", table, message);
+        return false;
+    }
+    return true;
+}
+
+void DataStore::addMigration(Migration migration)
+{
+    const auto it = std::lower_bound(m_migrations.begin(),
+                                     m_migrations.end(),
+                                     migration.version,
+                                     [](const Migration &m, int version) {
+                                         return m.version < version;
+                                     });
+    if ((it != m_migrations.end()) && (it->version == migration.version)) {
+        spdlog::error("DataStore: duplicate migration to version {}", migration.version);
+        return;
+    }
+    m_migrations.insert(it, std::move(migration));
+}
+
+const DataStore::Migration *DataStore::getMigration(int version) const
+{
+    for (const auto &migration : m_migrations) {
+        if (migration.version == version) {
+            return &migration;
+        }
+    }
+    return nullptr;
+}
+
+bool DataStore::migrate()
+{
+    auto db = getThreadLocalDatabase();
+    auto query = QSqlQuery(db);
+
+    // Backfill progress is tracked separately from the schema version.
+    if (!createTable("schema_migrations",
+                     {"version INTEGER PRIMARY KEY",
+                      "description TEXT",
+                      "cursor INTEGER",
+                      "completed INTEGER",
+                      "timestamp INTEGER"})) {
+        return false;
+    }
+
+    if (!query.exec("PRAGMA user_version") || !query.next()) {
+        const QString message = query.lastError().text();
+        spdlog::error("DataStore: failed to read schema version of {}: {}", m_filename, message);
+        return false;
+    }
+    const int current_version = query.value(0).toInt();
+    query.finish();
+
+    // Apply each upgrade in its own transaction.
+    for (const auto &migration : m_migrations) {
+        if (migration.version <= current_version) {
+            continue;
+        }
+        spdlog::info("DataStore: migrating {} to version {}: {}",
+                     m_filename,
+                     migration.version,
+                     migration.description);
+        if (!applyUpgrade(db, migration)) {
+            return false;
+        }
+    }
+
+    // Find backfills that haven't finished yet, including ones that were
+    // interrupted the last time the store was open.
+    std::vector<std::pair<int, qint64>> pending;
+    {
+        sql::Query<"SELECT version, cursor FROM schema_migrations"
+                   " WHERE completed = 0 ORDER BY version">
+            select(db);
+        if (!select.exec()) {
+            const QString message = select.errorText();
+            spdlog::error("DataStore: failed to read migrations of {}: {}", m_filename, message);
+            return false;
+        }
+        while (select.next()) {
+            pending.emplace_back(select.get<int>(0), select.get<qint64>(1));
+        }
+    }
+
+    if (!pending.empty()) {
+        m_backgroundPool->start([this, pending]() { runBackfills(pending); });
+    }
+    return true;
+}
+
+bool DataStore::applyUpgrade(QSqlDatabase &db, const Migration &migration)
+{
+    if (!db.transaction()) {
+        const QString message = db.lastError().text();
+        spdlog::error("DataStore: failed to begin migration {}: {}", migration.version, message);
+        return false;
+    }
+
+    bool ok = migration.upgrade ? migration.upgrade(db) : true;
+    QString message;
+
+    if (ok) {
+        sql::Query<"INSERT OR REPLACE INTO schema_migrations"
+                   " (version, description, cursor, completed, timestamp)"
+                   " VALUES"
+                   " (:version, :description, 0, :completed, :timestamp)">
+            insert(db);
+        insert.bind<":version">(migration.version);
+        insert.bind<":description">(migration.description);
+        insert.bind<":completed">(migration.backfill ? 0 : 1);
+        insert.bind<":timestamp">(QDateTime::currentMSecsSinceEpoch());
+        ok = insert.exec();
+        if (!ok) {
+            message = insert.errorText();
+        }
+    }
+    if (ok) {
+        // PRAGMA statements don't accept bound parameters.
+        auto query = QSqlQuery(db);
+        ok = query.exec(QString("PRAGMA user_version = %1").arg(migration.version));
+        if (!ok) {
+            message = query.lastError().text();
+        }
+    }
+    if (ok) {
+        ok = db.commit();
+    }
+
+    if (!ok) {
+        if (message.isEmpty()) {
+            message = db.lastError().text();
+        }
+        spdlog::error("DataStore: migration {} of {} failed: {}",
+                      migration.version,
+                      m_filename,
+                      message);
+        db.rollback();
+    }
+    return ok;
+}
+
+void DataStore::runBackfills(const std::vector<std::pair<int, qint64>> &pending)
+{
+    // This runs on the background pool with its own connection.
+    auto db = getThreadLocalDatabase();
+
+    for (auto [version, cursor] : pending) {
+        const Migration *migration = getMigration(version);
+        if (!migration || !migration->backfill) {
+            spdlog::warn("DataStore: no backfill for migration {} of {}", version, m_filename);
+            continue;
+        }
+
+        spdlog::info("DataStore: resuming migration {} of {} at {}", version, m_filename, cursor);
+
+        bool done = false;
+        while (!done) {
+            if (m_stopping) {
+                return;
+            }
+            if (!db.transaction()) {
+                const QString message = db.lastError().text();
+                spdlog::error("DataStore: failed to begin backfill {}: {}", version, message);
+                return;
+            }
+
+            const BatchResult result = migration->backfill(db, cursor);
+
+            bool ok = result.ok;
+            if (ok) {
+                sql::Query<"UPDATE schema_migrations"
+                           " SET cursor = :cursor, completed = :completed, timestamp = :timestamp"
+                           " WHERE version = :version">
+                    update(db);
+                update.bind<":cursor">(result.cursor);
+                update.bind<":completed">(result.done ? 1 : 0);
+                update.bind<":timestamp">(QDateTime::currentMSecsSinceEpoch());
+                update.bind<":version">(version);
+                ok = update.exec();
+                if (!ok) {
+                    const QString message = update.errorText();
+                    spdlog::error("DataStore: failed to save backfill {}: {}", version, message);
+                }
+            }
+            ok = ok && db.commit();
+            if (!ok) {
+                spdlog::error("DataStore: backfill {} of {} failed at {}",
+                              version,
+                              m_filename,
+                              cursor);
+                db.rollback();
+                return;
+            }
+
+            cursor = result.cursor;
+            done = result.done;
+        }
+
+        spdlog::info("DataStore: finished migration {} of {}", version, m_filename);
+        emit migrationFinished(version);
+    }
+}
+
+void DataStore::startBackgroundTask(std::function<void()> task)
+{
+    if (!m_stopping) {
+        m_backgroundPool->start(std::move(task));
+    }
+}
+
+void DataStore::stopBackgroundWork()
+{
+    m_stopping = true;
+    if (m_backgroundPool) {
+        m_backgroundPool->waitForDone();
+    }
 }
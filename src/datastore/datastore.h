@@ -8,26 +8,91 @@
 #include <QSet>
 #include <QSqlDatabase>
 #include <QString>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
 
 class DataStore : public QObject
 {
     Q_OBJECT
 
 public:
+    // Result of one batch of a background migration.
+    struct BatchResult
+    {
+        bool ok{false};
+        bool done{false};
+        qint64 cursor{0};
+    };
+
+    // A schema migration to a specific version, tracked with PRAGMA user_version.
+    //
+    // The upgrade runs synchronously inside a transaction and should be limited to
+    // fast schema changes. Data that needs to be rewritten is handled by the optional
+    // backfill, which runs in the background one batch per transaction. Each batch
+    // gets the cursor returned by the previous one (starting from zero), and the
+    // cursor is saved with the batch, so an interrupted backfill resumes where it
+    // left off the next time the store is opened.
+    struct Migration
+    {
+        int version{0};
+        QString description;
+        std::function<bool(QSqlDatabase &db)> upgrade;
+        std::function<BatchResult(QSqlDatabase &db, qint64 cursor)> backfill;
+    };
+
     DataStore(const QString &filename, QObject *parent = nullptr);
     ~DataStore();
 
+signals:
+    void migrationFinished(int version);
+
 protected:
+    void addMigration(Migration migration);
+
+    // Applies pending upgrades and starts any unfinished backfills. This
+    // should be called once by subclasses after adding their migrations.
+    bool migrate();
+
+    // Stops background work. Subclasses whose backfills depend on their own
+    // members must call this from their destructor.
+    void stopBackgroundWork();
+
+    // Runs a task on the background pool after any pending backfills.
+    void startBackgroundTask(std::function<void()> task);
+
     QSqlDatabase getThreadLocalDatabase();
 
-    void createTable(const QString &table, const QStringList &columns);
-    void createIndexes(const QString &table, const QStringList &columns);
+    // Returns a read-only connection for the calling thread. This is meant to be
+    // used from tasks running on readPool(), which bounds the number of readers.
+    QSqlDatabase getReadDatabase();
+
+    QThreadPool &readPool() { return *m_readPool; }
+
+    bool createTable(const QString &table, const QStringList &columns);
+    bool createIndexes(const QString &table, const QStringList &columns);
+    bool createFullTextTable(const QString &table, const QStringList &columns);
 
     const QString m_filename;
 
 private:
-    QString getThreadLocalConnectionName() const;
+    QString getThreadLocalConnectionName(const char *prefix) const;
+    QSqlDatabase openDatabase(const QString &connection, bool read_only);
+    void removeConnection(const QString &connection);
+
+    bool applyUpgrade(QSqlDatabase &db, const Migration &migration);
+    void runBackfills(const std::vector<std::pair<int, qint64>> &pending);
+    const Migration *getMigration(int version) const;
 
     mutable QMutex m_mutex;
     mutable QSet<QString> m_connections;
+
+    std::unique_ptr<QThreadPool> m_readPool;
+
+    std::vector<Migration> m_migrations;
+    std::unique_ptr<QThreadPool> m_backgroundPool;
+    std::atomic<bool> m_stopping{false};
 };
@@ -3,31 +3,35 @@
 
 #include "globalstore.h"
 
+#include "datastore/sqlquery.h"
 #include "util/spdlog_qt.h"
 
 static_assert(ACQUISITION_USE_SPDLOG); // Prevents an unused header warning in Qt Creator.
 
 #include <QDir>
 #include <QSqlDatabase>
-#include <QSqlError>
-#include <QSqlQuery>
 #include <QStandardPaths>
 
 GlobalStore::GlobalStore(QObject *parent)
     : DataStore(getPath("global.db"), parent)
 {
-    createTable("data", {"key TEXT PRIMARY KEY", "value BLOB"});
+    addMigration({1, "Initial schema", [this](QSqlDatabase &) {
+                      return createTable("data", {"key TEXT PRIMARY KEY", "value BLOB"});
+                  }});
+
+    if (!migrate()) {
+        spdlog::error("GlobalStore: failed to migrate the database");
+    }
 }
 
 void GlobalStore::set(const QString &key, const QVariant &value)
 {
     QSqlDatabase db = getThreadLocalDatabase();
-    QSqlQuery query(db);
-    query.prepare("INSERT OR REPLACE INTO data (key, value) VALUES (?, ?)");
-    query.bindValue(0, key);
-    query.bindValue(1, value);
+    sql::Query<"INSERT OR REPLACE INTO data (key, value) VALUES (:key, :value)"> query(db);
+    query.bind<":key">(key);
+    query.bind<":value">(value);
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("GlobalStore: error writing '{}': {}", key, message);
     }
 }
@@ -35,22 +39,21 @@ void GlobalStore::set(const QString &key, const QVariant &value)
 QVariant GlobalStore::get(const QString &key)
 {
     QSqlDatabase db = getThreadLocalDatabase();
-    QSqlQuery query(db);
-    query.prepare("SELECT value FROM data WHERE key = ?");
-    query.bindValue(0, key);
+    sql::Query<"SELECT value FROM data WHERE key = :key"> query(db);
+    query.bind<":key">(key);
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("GlobalStore: error reading '{}': {}", key, message);
         return QVariant();
     }
     if (!query.next()) {
-        if (!query.isActive()) {
-            const QString message = query.lastError().text();
+        const QString message = query.errorText();
+        if (!message.isEmpty()) {
             spdlog::error("GlobalStore: error getting '{}': {}", key, message);
         }
         return QVariant();
     }
-    return query.value(0);
+    return query.get<QVariant>(0);
 }
 
 QString GlobalStore::getPath(const QString &filename)
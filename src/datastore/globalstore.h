@@ -17,18 +17,24 @@ public:
     void set(const QString &key, const QVariant &value);
     QVariant get(const QString &key);
 
+    // Values are stored in binary form.
     template<typename T>
     void store(const QString &key, const T &value)
     {
-        const QString strval = json::toString(value);
-        set(key, strval);
+        set(key, json::toBinary(value));
     };
 
     template<typename T>
     std::pair<T, bool> retrieve(const QString &key)
     {
-        const QByteArray data = get(key).toByteArray();
-        return json::parse<T>(data, json::Mode::Strict);
+        // Values stored before the binary form was used are JSON text.
+        const QVariant value = get(key);
+        if (value.typeId() == QMetaType::QString) {
+            return json::parse<T, json::Mode::Strict>(value.toString().toUtf8());
+        }
+        T output{};
+        const bool ok = json::parse_binary_into(output, value.toByteArray());
+        return {std::move(output), ok};
     };
 
 private:
@@ -0,0 +1,321 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "itemhistory.h"
+
+#include "datastore/sqlquery.h"
+#include "util/arena.h"
+#include "util/json.h"
+#include "util/spdlog_qt.h"
+
+static_assert(ACQUISITION_USE_SPDLOG); // Prevents an unused header warning in Qt Creator.
+
+#include <QHash>
+
+#include <string_view>
+
+// Only the id is needed to match items between snapshots.
+struct ItemId
+{
+    std::optional<QString> id;
+};
+
+namespace {
+
+    constexpr qint64 MSECS_PER_DAY = 24LL * 60 * 60 * 1000;
+
+    // 64-bit FNV-1a. This needs to be stable across runs and Qt versions,
+    // because hashes are persisted in item_state.
+    quint64 fnv1a(std::string_view data)
+    {
+        quint64 hash = 0xcbf29ce484222325ULL;
+        for (const char c : data) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    std::optional<QString> getItemId(const poe::LazyItem &item)
+    {
+        ItemId id;
+        return item.decode(id) ? id.id : std::nullopt;
+    }
+
+    // Fills in the previous version of each removed or changed item.
+    bool loadPreviousItems(QSqlDatabase &db, history::StashDelta &delta)
+    {
+        sql::Query<"SELECT data FROM stashes WHERE id = :id"> query(db);
+        query.bind<":id">(delta.stash_id);
+        if (!query.exec()) {
+            const QString message = query.errorText();
+            spdlog::error("ItemHistory: failed to read stash '{}': {}", delta.stash_id, message);
+            return false;
+        }
+        if (!query.next()) {
+            spdlog::warn("ItemHistory: no previous snapshot of stash '{}'", delta.stash_id);
+            return true;
+        }
+
+        const QByteArray data = query.blob(0);
+        arena::ParseArena arena(data.size());
+        const auto items = poe::scanStashItems(data);
+        if (!items) {
+            spdlog::error("ItemHistory: error scanning previous snapshot of '{}'", delta.stash_id);
+            return false;
+        }
+
+        QHash<QString, std::string_view> previous;
+        for (const auto &item : items.value()) {
+            const auto id = getItemId(item);
+            if (id) {
+                previous.insert(id.value(), item.json());
+            }
+        }
+        for (auto &change : delta.changes) {
+            if (change.type != history::EventType::Added) {
+                const auto it = previous.constFind(change.item_id);
+                if (it != previous.cend()) {
+                    change.data = QByteArray(it->data(), static_cast<qsizetype>(it->size()));
+                }
+            }
+        }
+        return true;
+    }
+
+} // namespace
+
+std::vector<history::StashItem> history::stashItems(const std::vector<poe::LazyItem> &items)
+{
+    std::vector<StashItem> result;
+    result.reserve(items.size());
+    for (const auto &item : items) {
+        auto id = getItemId(item);
+        if (id) {
+            result.push_back({std::move(id.value()), item.json()});
+        }
+    }
+    return result;
+}
+
+history::StashDelta history::initialDelta(const QString &stash_id,
+                                          const std::vector<StashItem> &items)
+{
+    StashDelta delta;
+    delta.stash_id = stash_id;
+    delta.initial = true;
+    for (const auto &item : items) {
+        delta.changes.push_back({EventType::Added, item.id, fnv1a(item.json), {}});
+    }
+    return delta;
+}
+
+bool history::hasState(QSqlDatabase &db, const QString &stash_id, bool &has_state)
+{
+    sql::Query<"SELECT EXISTS (SELECT 1 FROM item_state WHERE stash_id = :stash_id)"> query(db);
+    query.bind<":stash_id">(stash_id);
+    if (!query.exec() || !query.next()) {
+        const QString message = query.errorText();
+        spdlog::error("ItemHistory: failed to check state of '{}': {}", stash_id, message);
+        return false;
+    }
+    has_state = query.get<bool>(0);
+    return true;
+}
+
+bool history::computeDelta(QSqlDatabase &db,
+                           const QString &stash_id,
+                           const std::vector<StashItem> &items,
+                           StashDelta &delta)
+{
+    // Load the recorded state of this stash.
+    QHash<QString, quint64> recorded;
+    {
+        sql::Query<"SELECT item_id, hash FROM item_state WHERE stash_id = :stash_id"> query(db);
+        query.bind<":stash_id">(stash_id);
+        if (!query.exec()) {
+            const QString message = query.errorText();
+            spdlog::error("ItemHistory: failed to read state of '{}': {}", stash_id, message);
+            return false;
+        }
+        while (query.next()) {
+            recorded.insert(query.get<QString>(0), static_cast<quint64>(query.get<qint64>(1)));
+        }
+    }
+
+    // A stash that has never been stored only seeds the state. So does one that
+    // was stored before history was tracked, until the backfill has seeded it,
+    // or every item in it would be recorded as added. Storing a stash replaces
+    // its row, so the backfill has not reached a stash whose rowid is past its
+    // cursor.
+    if (recorded.isEmpty()) {
+        sql::Query<"SELECT NOT EXISTS (SELECT 1 FROM stashes WHERE id = :id)"
+                   " OR EXISTS (SELECT 1 FROM stashes JOIN schema_migrations"
+                   " ON schema_migrations.version = :version"
+                   " AND schema_migrations.completed = 0"
+                   " AND stashes.rowid > schema_migrations.cursor"
+                   " WHERE stashes.id = :stash_id)">
+            query(db);
+        query.bind<":id">(stash_id);
+        query.bind<":stash_id">(stash_id);
+        query.bind<":version">(MIGRATION_VERSION);
+        if (!query.exec() || !query.next()) {
+            const QString message = query.errorText();
+            spdlog::error("ItemHistory: failed to check for stash '{}': {}", stash_id, message);
+            return false;
+        }
+        if (query.get<bool>(0)) {
+            delta = initialDelta(stash_id, items);
+            return true;
+        }
+    }
+
+    delta.stash_id = stash_id;
+    delta.changes.clear();
+    delta.initial = false;
+
+    bool need_previous = false;
+    for (const auto &item : items) {
+        const QString &item_id = item.id;
+        const quint64 hash = fnv1a(item.json);
+        const auto it = recorded.constFind(item_id);
+        if (it == recorded.cend()) {
+            delta.changes.push_back({EventType::Added, item_id, hash, {}});
+            continue;
+        }
+        if (it.value() != hash) {
+            delta.changes.push_back({EventType::Changed, item_id, hash, {}});
+            need_previous = true;
+        }
+        recorded.erase(it);
+    }
+
+    // Anything left over is no longer in the stash.
+    for (auto it = recorded.cbegin(); it != recorded.cend(); ++it) {
+        delta.changes.push_back({EventType::Removed, it.key(), 0, {}});
+        need_previous = true;
+    }
+
+    return need_previous ? loadPreviousItems(db, delta) : true;
+}
+
+bool history::writeDelta(QSqlDatabase &db, const StashDelta &delta, qint64 timestamp)
+{
+    sql::Query<"INSERT INTO item_events (stash_id, item_id, timestamp, event, data)"
+               " VALUES (:stash_id, :item_id, :timestamp, :event, :data)">
+        insert_event(db);
+
+    sql::Query<"INSERT OR REPLACE INTO item_state (stash_id, item_id, hash)"
+               " VALUES (:stash_id, :item_id, :hash)">
+        update_state(db);
+
+    sql::Query<"DELETE FROM item_state WHERE stash_id = :stash_id AND item_id = :item_id">
+        delete_state(db);
+
+    for (const auto &change : delta.changes) {
+        if (!delta.initial) {
+            insert_event.bind<":stash_id">(delta.stash_id);
+            insert_event.bind<":item_id">(change.item_id);
+            insert_event.bind<":timestamp">(timestamp);
+            insert_event.bind<":event">(static_cast<int>(change.type));
+            insert_event.bind<":data">(change.data.isNull() ? QVariant() : QVariant(change.data));
+            if (!insert_event.exec()) {
+                const QString message = insert_event.errorText();
+                spdlog::error("ItemHistory: failed to add event for '{}': {}",
+                              change.item_id,
+                              message);
+                return false;
+            }
+        }
+
+        bool ok;
+        if (change.type == EventType::Removed) {
+            delete_state.bind<":stash_id">(delta.stash_id);
+            delete_state.bind<":item_id">(change.item_id);
+            ok = delete_state.exec();
+        } else {
+            update_state.bind<":stash_id">(delta.stash_id);
+            update_state.bind<":item_id">(change.item_id);
+            update_state.bind<":hash">(static_cast<qint64>(change.hash));
+            ok = update_state.exec();
+        }
+        if (!ok) {
+            spdlog::error("ItemHistory: failed to update state for '{}'", change.item_id);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<history::ItemEvent> history::readEvents(QSqlDatabase &db,
+                                                    const QStringList &stash_ids,
+                                                    qint64 from,
+                                                    qint64 to,
+                                                    std::optional<EventType> type)
+{
+    // The stash ids are passed as a JSON array so the statement can be cached.
+    const std::vector<QString> ids(stash_ids.begin(), stash_ids.end());
+    const QString ids_json = QString::fromUtf8(json::toByteArray(ids));
+
+    sql::Query<"SELECT id, timestamp, event, stash_id, item_id, data FROM item_events"
+               " WHERE timestamp >= :from AND timestamp < :to"
+               " AND (:any_stash OR stash_id IN (SELECT value FROM json_each(:stash_ids)))"
+               " AND (:event = 0 OR event = :event)"
+               " ORDER BY timestamp, id">
+        query(db);
+    query.bind<":from">(from);
+    query.bind<":to">(to);
+    query.bind<":any_stash">(stash_ids.isEmpty());
+    query.bind<":stash_ids">(ids_json);
+    query.bind<":event">(type ? static_cast<int>(type.value()) : 0);
+
+    if (!query.exec()) {
+        const QString message = query.errorText();
+        spdlog::error("ItemHistory: failed to read events: {}", message);
+        return {};
+    }
+
+    std::vector<ItemEvent> events;
+    while (query.next()) {
+        ItemEvent &event = events.emplace_back();
+        event.id = query.get<qint64>(0);
+        event.timestamp = query.get<qint64>(1);
+        event.type = static_cast<EventType>(query.get<int>(2));
+        event.stash_id = query.get<QString>(3);
+        event.item_id = query.get<QString>(4);
+        event.data = query.blob(5);
+    }
+    return events;
+}
+
+bool history::compact(QSqlDatabase &db, qint64 now, const RetentionPolicy &policy)
+{
+    sql::Query<"DELETE FROM item_events WHERE timestamp < :expired"> prune(db);
+    prune.bind<":expired">(now - policy.keep_for_ms);
+    if (!prune.exec()) {
+        const QString message = prune.errorText();
+        spdlog::error("ItemHistory: failed to delete expired events: {}", message);
+        return false;
+    }
+
+    // Keep the earliest change per item per day, which holds the
+    // version of the item from the start of that day.
+    sql::Query<"DELETE FROM item_events"
+               " WHERE event = :changed AND timestamp < :before"
+               " AND EXISTS (SELECT 1 FROM item_events AS earlier"
+               " WHERE earlier.event = :changed"
+               " AND earlier.stash_id = item_events.stash_id"
+               " AND earlier.item_id = item_events.item_id"
+               " AND earlier.timestamp / :day = item_events.timestamp / :day"
+               " AND earlier.id < item_events.id)">
+        collapse(db);
+    collapse.bind<":changed">(static_cast<int>(EventType::Changed));
+    collapse.bind<":before">(now - policy.compact_after_ms);
+    collapse.bind<":day">(MSECS_PER_DAY);
+    if (!collapse.exec()) {
+        const QString message = collapse.errorText();
+        spdlog::error("ItemHistory: failed to compact changes: {}", message);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "poe/types/lazyitem.h"
+
+#include <QByteArray>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Item history is stored as deltas against the latest stash snapshot, which
+// is the only full copy that is kept. A hash of every item currently in each
+// stash is kept in item_state, and every refresh appends one event for each
+// item that was added, removed, or changed.
+//
+// Events store the version of the item that the refresh replaced, so that
+// together with the current snapshot any earlier version can be recovered.
+// Added events have no data, since the item is still in the stash. Items are
+// hashed and stored as the JSON they were received in, so nothing beyond the
+// item ids needs to be decoded.
+
+namespace history {
+
+    // The schema migration that adds item history. Its backfill seeds the state
+    // of stashes that were stored before history was tracked.
+    constexpr int MIGRATION_VERSION = 4;
+
+    enum class EventType : int { Added = 1, Removed = 2, Changed = 3 };
+
+    struct ItemEvent
+    {
+        qint64 id{0};
+        qint64 timestamp{0};
+        EventType type{EventType::Added};
+        QString stash_id;
+        QString item_id;
+        QByteArray data; // JSON of the item before this event.
+    };
+
+    // The difference between the recorded state of a stash and a refresh.
+    struct StashDelta
+    {
+        struct Change
+        {
+            EventType type;
+            QString item_id;
+            quint64 hash{0};
+            QByteArray data;
+        };
+
+        QString stash_id;
+        std::vector<Change> changes;
+
+        // The first snapshot of a stash only seeds the state.
+        bool initial{false};
+    };
+
+    struct RetentionPolicy
+    {
+        // Changes older than this are collapsed to the first one per item per day.
+        qint64 compact_after_ms{7LL * 24 * 60 * 60 * 1000};
+        // Events older than this are deleted.
+        qint64 keep_for_ms{180LL * 24 * 60 * 60 * 1000};
+    };
+
+    // An item of a stash as history sees it: its id, and the JSON it arrived
+    // as, which is what is hashed and stored.
+    struct StashItem
+    {
+        QString id;
+        std::string_view json;
+    };
+
+    // Decodes the id of each item. Items without an id are left out.
+    std::vector<StashItem> stashItems(const std::vector<poe::LazyItem> &items);
+
+    // Compares the incoming items of a stash with its recorded state. The stored
+    // snapshot is only read when items were removed or changed, and this must be
+    // called before that snapshot is replaced.
+    bool computeDelta(QSqlDatabase &db,
+                      const QString &stash_id,
+                      const std::vector<StashItem> &items,
+                      StashDelta &delta);
+
+    // Records the current items of a stash without any events. This is used to
+    // seed the state for stashes that were stored before history was tracked.
+    StashDelta initialDelta(const QString &stash_id, const std::vector<StashItem> &items);
+
+    // Sets has_state to whether any items of a stash are recorded.
+    bool hasState(QSqlDatabase &db, const QString &stash_id, bool &has_state);
+
+    // Appends events and updates the recorded state. This must be called inside a transaction.
+    bool writeDelta(QSqlDatabase &db, const StashDelta &delta, qint64 timestamp);
+
+    // Returns events in [from, to) for the given stashes, oldest first. An empty
+    // list of stash ids matches every stash.
+    std::vector<ItemEvent> readEvents(QSqlDatabase &db,
+                                      const QStringList &stash_ids,
+                                      qint64 from,
+                                      qint64 to,
+                                      std::optional<EventType> type);
+
+    // Applies a retention policy relative to the given time.
+    bool compact(QSqlDatabase &db, qint64 now, const RetentionPolicy &policy);
+
+} // namespace history
@@ -0,0 +1,54 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "sqlquery.h"
+
+#include "util/spdlog_qt.h"
+
+static_assert(ACQUISITION_USE_SPDLOG); // Prevents an unused header warning in Qt Creator.
+
+#include <QHash>
+
+#include <unordered_map>
+
+namespace {
+
+    // Statement text lives in a template parameter object, so its address is
+    // a unique and stable key.
+    using Statements = std::unordered_map<const char *, sql::CachedStatement>;
+
+    thread_local QHash<QString, Statements> t_statements;
+
+} // namespace
+
+sql::CachedStatement *sql::claimStatement(const QSqlDatabase &db, const char *statement)
+{
+    Statements &statements = t_statements[db.connectionName()];
+
+    auto it = statements.find(statement);
+    if (it == statements.end()) {
+        it = statements.emplace(statement, CachedStatement{prepareStatement(db, statement)}).first;
+    } else if (it->second.in_use) {
+        return nullptr;
+    } else if (it->second.query.lastError().isValid()) {
+        it->second.query = prepareStatement(db, statement);
+    }
+    it->second.in_use = true;
+    return &it->second;
+}
+
+QSqlQuery sql::prepareStatement(const QSqlDatabase &db, const char *statement)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.prepare(QString::fromUtf8(statement))) {
+        const QString message = query.lastError().text();
+        spdlog::error("DataStore: failed to prepare '{}': {}", statement, message);
+    }
+    return query;
+}
+
+void sql::releaseStatements(const QString &connection)
+{
+    t_statements.remove(connection);
+}
@@ -0,0 +1,145 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QString>
+#include <QVariant>
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+namespace sql {
+
+    // A string literal that can be used as a template argument.
+    template<size_t N>
+    struct Text
+    {
+        consteval Text(const char (&text)[N]) { std::copy_n(text, N, value); }
+
+        constexpr std::string_view view() const { return {value, N - 1}; }
+
+        char value[N];
+    };
+
+    // Returns true if a statement contains a named placeholder. The name must
+    // not be followed by another identifier character, so ":time" does not
+    // match ":timestamp".
+    consteval bool hasPlaceholder(std::string_view statement, std::string_view name)
+    {
+        const auto is_identifier = [](char c) {
+            return (c == '_') || ((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z'))
+                   || ((c >= 'A') && (c <= 'Z'));
+        };
+        size_t pos = statement.find(name);
+        while (pos != std::string_view::npos) {
+            const size_t end = pos + name.size();
+            if ((end == statement.size()) || !is_identifier(statement[end])) {
+                return true;
+            }
+            pos = statement.find(name, end);
+        }
+        return false;
+    }
+
+    // A prepared statement that is kept for reuse, and whether a Query has it.
+    struct CachedStatement
+    {
+        QSqlQuery query;
+        bool in_use{false};
+    };
+
+    // Claims the prepared statement for a connection, preparing it on first use.
+    // Statements are cached per thread, which is also how connections are owned.
+    // A statement whose last use failed is prepared again. Returns nullptr if
+    // the statement is already claimed.
+    CachedStatement *claimStatement(const QSqlDatabase &db, const char *statement);
+
+    // Prepares a statement that is not cached.
+    QSqlQuery prepareStatement(const QSqlDatabase &db, const char *statement);
+
+    // Drops the cached statements for a connection. This must be called from
+    // the thread that owns the connection before it is removed.
+    void releaseStatements(const QString &connection);
+
+    // A prepared statement whose named parameters are checked at compile time.
+    //
+    //     sql::Query<"SELECT data FROM stashes WHERE id = :id"> query(db);
+    //     query.bind<":id">(id);
+    //
+    // The underlying statement is reused by every Query with the same text on
+    // the same connection. If another Query is still using it, this one
+    // prepares a statement of its own instead.
+    template<Text Statement>
+    class Query
+    {
+    public:
+        explicit Query(const QSqlDatabase &db)
+            : m_cached(claimStatement(db, Statement.value))
+        {
+            if (m_cached) {
+                m_query = &m_cached->query;
+            } else {
+                m_query = &m_own.emplace(prepareStatement(db, Statement.value));
+            }
+        }
+
+        ~Query()
+        {
+            m_query->finish();
+            if (m_cached) {
+                m_cached->in_use = false;
+            }
+        }
+
+        Query(const Query &) = delete;
+        Query &operator=(const Query &) = delete;
+
+        template<Text Name>
+        void bind(const QVariant &value)
+        {
+            static_assert(Name.view().starts_with(':'), "Placeholder names must start with ':'");
+            static_assert(hasPlaceholder(Statement.view(), Name.view()),
+                          "Placeholder is not used by this statement");
+            static const QString placeholder = QString::fromLatin1(Name.view());
+            m_query->bindValue(placeholder, value);
+        }
+
+        bool exec() { return m_query->exec(); }
+        bool next() { return m_query->next(); }
+        void finish() { m_query->finish(); }
+
+        // Converts a column value. QtSql only returns values inside a QVariant,
+        // so the value is cast out of that temporary.
+        template<typename T>
+        T get(int column)
+        {
+            if constexpr (std::is_same_v<T, QVariant>) {
+                return m_query->value(column);
+            } else {
+                return qvariant_cast<T>(m_query->value(column));
+            }
+        }
+
+        // BLOB columns already hold a QByteArray, which is taken out of the
+        // QVariant without a conversion. It shares the buffer the driver filled
+        // in, so the bytes are not copied again.
+        QByteArray blob(int column) { return m_query->value(column).toByteArray(); }
+
+        QVariant lastInsertId() const { return m_query->lastInsertId(); }
+        QString errorText() const { return m_query->lastError().text(); }
+
+    private:
+        CachedStatement *m_cached{nullptr};
+        std::optional<QSqlQuery> m_own;
+        QSqlQuery *m_query{nullptr};
+    };
+
+} // namespace sql
@@ -3,6 +3,9 @@
 
 #include "userstore.h"
 
+#include "datastore/sqlquery.h"
+#include "poe/types/lazyitem.h"
+#include "util/arena.h"
 #include "util/json.h"
 #include "util/spdlog_qt.h"
 
@@ -10,10 +13,14 @@ static_assert(ACQUISITION_USE_SPDLOG); // Prevents an unused header warning in Q
 
 #include <QDir>
 #include <QSqlError>
-#include <QSqlQuery>
 #include <QStandardPaths>
 
-constexpr auto JSON_MODE = json::Mode::Strict;
+#include <atomic>
+
+// New fields from the API are logged and skipped instead of failing the parse.
+constexpr auto JSON_MODE = json::Mode::Permissive;
+
+constexpr history::RetentionPolicy HISTORY_POLICY{};
 
 // Cannot declare these structures in an anonymous namespace
 // because glaze needs to use them.
@@ -43,45 +50,505 @@ struct StashTabWrapper
     std::optional<poe::StashTab> stash;
 };
 
+// The fields needed to store a character that could not be fully decoded.
+struct CharacterHeader
+{
+    QString id;
+    QString name;
+    QString realm;
+    std::optional<QString> league;
+};
+
+struct CharacterHeaderWrapper
+{
+    std::optional<CharacterHeader> character;
+};
+
+// The fields of an item that are indexed for search. These are only kept
+// while a stash is being indexed, so the lists can live in a parse arena.
+struct SearchableItem
+{
+    std::optional<QString> id;
+    QString name;
+    QString typeLine;
+    QString baseType;
+    std::optional<arena::vector<QString>> implicitMods;
+    std::optional<arena::vector<QString>> enchantMods;
+    std::optional<arena::vector<QString>> scourgeMods;
+    std::optional<arena::vector<QString>> utilityMods;
+    std::optional<arena::vector<QString>> fracturedMods;
+    std::optional<arena::vector<QString>> explicitMods;
+    std::optional<arena::vector<QString>> craftedMods;
+    std::optional<arena::vector<QString>> crucibleMods;
+    std::optional<arena::vector<QString>> cosmeticMods;
+    std::optional<arena::vector<glz::raw_json_view>> socketedItems;
+};
+
+namespace {
+
+    // Flattens a list of items and their socketed items for the search index.
+    void collectItems(const std::vector<poe::Item> &items, std::vector<const poe::Item *> &output)
+    {
+        for (const auto &item : items) {
+            output.push_back(&item);
+            if (item.socketedItems) {
+                collectItems(item.socketedItems.value(), output);
+            }
+        }
+    }
+
+    void collectItems(const poe::Character &character, std::vector<const poe::Item *> &output)
+    {
+        for (const auto *collection : {&character.equipment,
+                                       &character.inventory,
+                                       &character.rucksack,
+                                       &character.jewels}) {
+            if (*collection) {
+                collectItems(collection->value(), output);
+            }
+        }
+    }
+
+    // Decodes only the searchable fields of stored items and their socketed items.
+    void collectItems(const std::vector<poe::LazyItem> &items,
+                      arena::vector<SearchableItem> &output)
+    {
+        for (const auto &item : items) {
+            SearchableItem searchable;
+            if (!item.decode(searchable)) {
+                continue;
+            }
+            const auto &socketed = output.emplace_back(std::move(searchable)).socketedItems;
+            if (socketed) {
+                const auto socketed_items = poe::toLazyItems(item.source(), socketed.value());
+                collectItems(socketed_items, output);
+            }
+        }
+    }
+
+    template<typename List>
+    void appendMods(const std::optional<List> &mods, QStringList &output)
+    {
+        if (mods) {
+            for (const auto &mod : mods.value()) {
+                output.append(mod);
+            }
+        }
+    }
+
+    template<typename Item>
+    QString getSearchableMods(const Item &item)
+    {
+        QStringList mods;
+        appendMods(item.implicitMods, mods);
+        appendMods(item.enchantMods, mods);
+        appendMods(item.scourgeMods, mods);
+        appendMods(item.utilityMods, mods);
+        appendMods(item.fracturedMods, mods);
+        appendMods(item.explicitMods, mods);
+        appendMods(item.craftedMods, mods);
+        appendMods(item.crucibleMods, mods);
+        appendMods(item.cosmeticMods, mods);
+        return mods.join("\n");
+    }
+
+    // Converts user input into an FTS5 match expression. Every term is quoted so
+    // that punctuation in mod text (e.g. "+", "%", "-") is never parsed as FTS5
+    // syntax. Bare words become prefix queries and quoted text stays a phrase.
+    QString getMatchExpression(const QString &text)
+    {
+        QStringList terms;
+        QString current;
+        bool in_phrase = false;
+
+        const auto flush = [&](bool prefix) {
+            const QString term = current.trimmed();
+            current.clear();
+            if (!term.isEmpty()) {
+                QString quoted = term;
+                quoted.replace('"', "\"\"");
+                terms.append("\"" + quoted + "\"" + (prefix ? "*" : ""));
+            }
+        };
+
+        for (const QChar c : text) {
+            if (c == '"') {
+                flush(!in_phrase);
+                in_phrase = !in_phrase;
+            } else if (c.isSpace() && !in_phrase) {
+                flush(true);
+            } else {
+                current.append(c);
+            }
+        }
+        flush(!in_phrase);
+
+        return terms.join(' ');
+    }
+
+    // Replaces the search entries for an owner. This must be called inside a transaction.
+    template<typename Item>
+    bool writeSearchIndex(QSqlDatabase &db,
+                          const QString &owner,
+                          const std::vector<const Item *> &items)
+    {
+        // Remove whatever was previously indexed for this owner.
+        sql::Query<"DELETE FROM search_items WHERE rowid IN"
+                   " (SELECT rowid FROM search_rows WHERE owner = :owner)">
+            delete_text(db);
+        delete_text.bind<":owner">(owner);
+        if (!delete_text.exec()) {
+            const QString message = delete_text.errorText();
+            spdlog::error("UserStore: failed to clear search text for {}: {}", owner, message);
+            return false;
+        }
+
+        sql::Query<"DELETE FROM search_rows WHERE owner = :owner"> delete_rows(db);
+        delete_rows.bind<":owner">(owner);
+        if (!delete_rows.exec()) {
+            const QString message = delete_rows.errorText();
+            spdlog::error("UserStore: failed to clear search rows for {}: {}", owner, message);
+            return false;
+        }
+
+        // Add the current items.
+        sql::Query<"INSERT INTO search_rows (item_id, owner) VALUES (:item_id, :owner)">
+            insert_row(db);
+
+        sql::Query<"INSERT INTO search_items (rowid, name, type_line, base_type, mods)"
+                   " VALUES (:rowid, :name, :type_line, :base_type, :mods)">
+            insert_text(db);
+
+        for (const Item *item : items) {
+            insert_row.bind<":item_id">(item->id.value_or(""));
+            insert_row.bind<":owner">(owner);
+            if (!insert_row.exec()) {
+                const QString message = insert_row.errorText();
+                spdlog::error("UserStore: failed to add search row for {}: {}", owner, message);
+                return false;
+            }
+
+            const QString name = item->name.isEmpty() ? item->typeLine
+                                                      : item->name + " " + item->typeLine;
+            insert_text.bind<":rowid">(insert_row.lastInsertId());
+            insert_text.bind<":name">(name);
+            insert_text.bind<":type_line">(item->typeLine);
+            insert_text.bind<":base_type">(item->baseType);
+            insert_text.bind<":mods">(getSearchableMods(*item));
+            if (!insert_text.exec()) {
+                const QString message = insert_text.errorText();
+                spdlog::error("UserStore: failed to add search text for {}: {}", owner, message);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Number of stashes or characters rewritten per background transaction.
+    constexpr int BACKFILL_BATCH_SIZE = 50;
+
+    constexpr sql::Text BACKFILL_STASHES{"SELECT rowid, id, data FROM stashes"
+                                         " WHERE rowid > :cursor ORDER BY rowid LIMIT :limit"};
+
+    constexpr sql::Text BACKFILL_CHARACTERS{"SELECT rowid, id, data FROM characters"
+                                            " WHERE rowid > :cursor ORDER BY rowid LIMIT :limit"};
+
+    // Passes a batch of stored stashes or characters to the handler in rowid order.
+    template<sql::Text Statement, typename Handler>
+    DataStore::BatchResult backfill(QSqlDatabase &db,
+                                    const QString &table,
+                                    qint64 cursor,
+                                    Handler &&handler)
+    {
+        DataStore::BatchResult result;
+        result.cursor = cursor;
+
+        sql::Query<Statement> query(db);
+        query.template bind<":cursor">(cursor);
+        query.template bind<":limit">(BACKFILL_BATCH_SIZE);
+        if (!query.exec()) {
+            const QString message = query.errorText();
+            spdlog::error("UserStore: failed to read {} for a backfill: {}", table, message);
+            return result;
+        }
+
+        int count = 0;
+        while (query.next()) {
+            ++count;
+            result.cursor = query.template get<qint64>(0);
+            const QString owner = query.template get<QString>(1);
+            const QByteArray data = query.blob(2);
+            if (!handler(db, owner, data)) {
+                return result;
+            }
+        }
+
+        result.ok = true;
+        result.done = (count < BACKFILL_BATCH_SIZE);
+        return result;
+    }
+
+    // Stored stashes are only scanned, and only the searchable fields of their
+    // items are decoded, with everything transient allocated from an arena.
+    bool indexStash(QSqlDatabase &db, const QString &owner, const QByteArray &data)
+    {
+        arena::ParseArena arena(data.size());
+
+        const auto items = poe::scanStashItems(data);
+        if (!items) {
+            spdlog::warn("UserStore: skipping unparseable stash '{}'", owner);
+            return true;
+        }
+        arena::vector<SearchableItem> searchable;
+        collectItems(items.value(), searchable);
+
+        std::vector<const SearchableItem *> pointers;
+        pointers.reserve(searchable.size());
+        for (const auto &item : searchable) {
+            pointers.push_back(&item);
+        }
+        return writeSearchIndex(db, owner, pointers);
+    }
+
+    bool indexCharacter(QSqlDatabase &db, const QString &owner, const QByteArray &data)
+    {
+        poe::CharacterWrapper wrapper;
+        if (!json::parse_into<JSON_MODE>(wrapper, data)) {
+            spdlog::warn("UserStore: skipping unparseable character '{}'", owner);
+            return true;
+        }
+        std::vector<const poe::Item *> items;
+        if (wrapper.character) {
+            collectItems(wrapper.character.value(), items);
+        }
+        return writeSearchIndex(db, owner, items);
+    }
+
+    bool seedItemHistory(QSqlDatabase &db, const QString &owner, const QByteArray &data)
+    {
+        // A stash that was refreshed since history was added already has its
+        // state, and this snapshot may be older than that state.
+        bool has_state = false;
+        if (!history::hasState(db, owner, has_state)) {
+            return false;
+        }
+        if (has_state) {
+            return true;
+        }
+
+        arena::ParseArena arena(data.size());
+        const auto items = poe::scanStashItems(data);
+        if (!items) {
+            spdlog::warn("UserStore: skipping unparseable stash '{}'", owner);
+            return true;
+        }
+        const auto delta = history::initialDelta(owner, history::stashItems(items.value()));
+        return history::writeDelta(db, delta, 0);
+    }
+
+    bool insertCharacter(QSqlDatabase &db,
+                         const QString &id,
+                         const QString &name,
+                         const QString &realm,
+                         const QString &league,
+                         const QByteArray &data)
+    {
+        sql::Query<"INSERT OR REPLACE INTO characters"
+                   " (id, name, realm, league, timestamp, data)"
+                   " VALUES"
+                   " (:id, :name, :realm, :league, :timestamp, :data)">
+            query(db);
+        query.bind<":id">(id);
+        query.bind<":name">(name);
+        query.bind<":realm">(realm);
+        query.bind<":league">(league);
+        query.bind<":timestamp">(QDateTime::currentMSecsSinceEpoch());
+        query.bind<":data">(data);
+
+        if (!query.exec()) {
+            const QString message = query.errorText();
+            spdlog::error("UserStore: failed to update character '{}' in {} realm: {}",
+                          name,
+                          realm,
+                          message);
+            return false;
+        }
+        return true;
+    }
+
+    // Works with both full and lazily scanned stashes.
+    template<typename Stash>
+    bool insertStash(QSqlDatabase &db,
+                     const Stash &stash,
+                     const QString &realm,
+                     const QString &league,
+                     qint64 timestamp,
+                     const QByteArray &data)
+    {
+        sql::Query<"INSERT OR REPLACE INTO stashes"
+                   " (id, parent, name, type, stash_index, realm, league, timestamp, data)"
+                   " VALUES"
+                   " (:id, :parent, :name, :type, :stash_index,"
+                   " :realm, :league, :timestamp, :data)">
+            query(db);
+        query.bind<":id">(stash.id);
+        query.bind<":parent">(stash.parent.value_or(""));
+        query.bind<":name">(stash.name);
+        query.bind<":type">(stash.type);
+        if (stash.index) {
+            query.bind<":stash_index">(stash.index.value());
+        } else {
+            query.bind<":stash_index">("");
+        }
+        query.bind<":realm">(realm);
+        query.bind<":league">(league);
+        query.bind<":timestamp">(timestamp);
+        query.bind<":data">(data);
+
+        if (!query.exec()) {
+            const QString message = query.errorText();
+            spdlog::error("UserStore: failed to update stash '{}' for {} realm in {} league: {}",
+                          stash.id,
+                          realm,
+                          league,
+                          message);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace
+
+// State shared between the read pool workers of a single loadStashes() call.
+// Only the ids are read by the workers; everything else is touched on the
+// thread that owns the UserStore.
+struct UserStore::StashLoad
+{
+    std::vector<QString> ids;
+    std::vector<std::optional<poe::StashTab>> stashes;
+    size_t remaining{0};
+    std::atomic<bool> cancelled{false};
+};
+
 UserStore::UserStore(const QString &username, QObject *parent)
     : DataStore(getPath(username), parent)
+{
+    addMigration({1, "Initial schema", [this](QSqlDatabase &) { return createInitialSchema(); }});
+
+    addMigration({2,
+                  "Full-text search for stash items",
+                  [this](QSqlDatabase &) { return createSearchSchema(); },
+                  [](QSqlDatabase &db, qint64 cursor) {
+                      return backfill<BACKFILL_STASHES>(db, "stashes", cursor, indexStash);
+                  }});
+
+    addMigration({3,
+                  "Full-text search for character items",
+                  nullptr,
+                  [](QSqlDatabase &db, qint64 cursor) {
+                      return backfill<BACKFILL_CHARACTERS>(db,
+                                                           "characters",
+                                                           cursor,
+                                                           indexCharacter);
+                  }});
+
+    addMigration({history::MIGRATION_VERSION,
+                  "Item history",
+                  [this](QSqlDatabase &) { return createHistorySchema(); },
+                  [](QSqlDatabase &db, qint64 cursor) {
+                      return backfill<BACKFILL_STASHES>(db, "stashes", cursor, seedItemHistory);
+                  }});
+
+    if (!migrate()) {
+        spdlog::error("UserStore: failed to migrate the database for '{}'", username);
+    }
+
+    startBackgroundTask([this]() { compactItemHistory(); });
+}
+
+UserStore::~UserStore()
+{
+    stopBackgroundWork();
+    if (m_stashLoad) {
+        m_stashLoad->cancelled = true;
+    }
+    readPool().waitForDone();
+}
+
+bool UserStore::createInitialSchema()
 {
     // List of available chararacters and stashes are stored here.
-    createTable("indexes",
-                {"name TEXT", "realm TEXT", "league TEXT", "timestamp INTEGER", "data TEXT"});
+    bool ok = createTable("indexes",
+                          {"name TEXT",
+                           "realm TEXT",
+                           "league TEXT",
+                           "timestamp INTEGER",
+                           "data TEXT"});
 
     // Full character data with items is stored here.
-    createTable("characters",
-                {"id TEXT PRIMARY KEY",
-                 "name TEXT",
-                 "realm TEXT",
-                 "league TEXT",
-                 "timestamp INTEGER",
-                 "data BLOB"});
+    ok = ok
+         && createTable("characters",
+                        {"id TEXT PRIMARY KEY",
+                         "name TEXT",
+                         "realm TEXT",
+                         "league TEXT",
+                         "timestamp INTEGER",
+                         "data BLOB"});
 
     // Full stash data with items is stored here.
-    createTable("stashes",
-                {"id TEXT PRIMARY KEY",
-                 "parent TEXT REFERENCES stashes(id)",
-                 "name TEXT",
-                 "type TEXT",
-                 "stash_index INTEGER",
-                 "realm TEXT",
-                 "league TEXT",
-                 "timestamp INTEGER",
-                 "data BLOB"});
-
-    createTable("buyouts",
-                {"item_id TEXT",
-                 "stash_id TEXT REFERENCES stashes(id)",
-                 "note TEXT",
-                 "source TEXT",
-                 "timestamp INTEGER"});
+    ok = ok
+         && createTable("stashes",
+                        {"id TEXT PRIMARY KEY",
+                         "parent TEXT REFERENCES stashes(id)",
+                         "name TEXT",
+                         "type TEXT",
+                         "stash_index INTEGER",
+                         "realm TEXT",
+                         "league TEXT",
+                         "timestamp INTEGER",
+                         "data BLOB"});
+
+    ok = ok
+         && createTable("buyouts",
+                        {"item_id TEXT",
+                         "stash_id TEXT REFERENCES stashes(id)",
+                         "note TEXT",
+                         "source TEXT",
+                         "timestamp INTEGER"});
 
     // Add indexes for the most common use cases.
-    createIndexes("characters", {"realm", "league"});
-    createIndexes("stashes", {"realm", "league", "parent", "type"});
-    createIndexes("buyouts", {"item_id", "stash_id"});
+    ok = ok && createIndexes("characters", {"realm", "league"});
+    ok = ok && createIndexes("stashes", {"realm", "league", "parent", "type"});
+    ok = ok && createIndexes("buyouts", {"item_id", "stash_id"});
+    return ok;
+}
+
+bool UserStore::createSearchSchema()
+{
+    // Item text is indexed for full-text search. The rowid of each search
+    // entry is shared with search_rows, which maps it back to an item.
+    return createTable("search_rows", {"rowid INTEGER PRIMARY KEY", "item_id TEXT", "owner TEXT"})
+           && createFullTextTable("search_items", {"name", "type_line", "base_type", "mods"})
+           && createIndexes("search_rows", {"owner"});
+}
+
+bool UserStore::createHistorySchema()
+{
+    // Item history is appended to item_events. The hash of every item
+    // currently in a stash is kept in item_state to detect changes.
+    return createTable("item_state",
+                       {"stash_id TEXT",
+                        "item_id TEXT",
+                        "hash INTEGER",
+                        "PRIMARY KEY (stash_id, item_id)"})
+           && createTable("item_events",
+                          {"id INTEGER PRIMARY KEY",
+                           "stash_id TEXT",
+                           "item_id TEXT",
+                           "timestamp INTEGER",
+                           "event INTEGER",
+                           "data BLOB"})
+           && createIndexes("item_events", {"stash_id", "item_id", "timestamp"});
 }
 
 void UserStore::connectTo(PoeClient &client)
@@ -98,20 +565,18 @@ void UserStore::connectTo(PoeClient &client)
 
 QStringList UserStore::getLeagueNames(const QString &realm)
 {
-    const QString statement{"SELECT league FROM characters WHERE realm = :realm"
-                            " UNION"
-                            " SELECT league FROM stashes WHERE realm = :realm"
-                            " ORDER BY league"};
-
     // Build the query.
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":realm", realm);
+    sql::Query<"SELECT league FROM characters WHERE realm = :realm"
+               " UNION"
+               " SELECT league FROM stashes WHERE realm = :realm"
+               " ORDER BY league">
+        query(db);
+    query.bind<":realm">(realm);
 
     // Run the query.
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to get leagues realm='{}': {}", realm, message);
         return {};
     }
@@ -119,7 +584,7 @@ QStringList UserStore::getLeagueNames(const QString &realm)
     // Return the results.
     QStringList names;
     while (query.next()) {
-        names.append(query.value(0).toString());
+        names.append(query.get<QString>(0));
     }
     return std::move(names);
 }
@@ -128,7 +593,7 @@ std::vector<poe::League> UserStore::getLeagueList(const QString &realm)
 {
     poe::LeagueListWrapper wrapper;
     const QByteArray data = getIndex("leagues", realm, "");
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing leagues index");
         return {};
@@ -140,7 +605,7 @@ std::vector<poe::Character> UserStore::getCharacterList(const QString &realm)
 {
     poe::CharacterListWrapper wrapper;
     const QByteArray data = getIndex("characters", realm, "");
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing character list");
         return {};
@@ -152,7 +617,7 @@ std::vector<poe::StashTab> UserStore::getStashList(const QString &realm, const Q
 {
     poe::StashListWrapper wrapper;
     const QByteArray data = getIndex("stashes", realm, league);
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing stash index");
         return {};
@@ -162,29 +627,26 @@ std::vector<poe::StashTab> UserStore::getStashList(const QString &realm, const Q
 
 std::optional<poe::Character> UserStore::getCharacter(const QString &realm, const QString &name)
 {
-    const QString statement{"SELECT data FROM characters WHERE realm = :realm AND name = :name"};
-
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":realm", realm);
-    query.bindValue(":name", name);
+    sql::Query<"SELECT data FROM characters WHERE realm = :realm AND name = :name"> query(db);
+    query.bind<":realm">(realm);
+    query.bind<":name">(name);
 
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to load league index for realm='{}': {}", realm, message);
         return {};
     }
 
     if (!query.next()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to read league index for realm='{}': {}", realm, message);
         return {};
     }
 
     poe::CharacterWrapper wrapper;
-    const QByteArray data = query.value(0).toByteArray();
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const QByteArray data = query.blob(0);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing character wrapper");
         return {};
@@ -196,32 +658,30 @@ std::optional<poe::StashTab> UserStore::getStash(const QString &realm,
                                                  const QString &league,
                                                  const QString &id)
 {
-    const QString statement{"SELECT data FROM stashes WHERE realm = :realm"
-                            " AND league = :league"
-                            " AND id = :id"};
-
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":realm", realm);
-    query.bindValue(":league", league);
-    query.bindValue(":id", id);
+    sql::Query<"SELECT data FROM stashes WHERE realm = :realm"
+               " AND league = :league"
+               " AND id = :id">
+        query(db);
+    query.bind<":realm">(realm);
+    query.bind<":league">(league);
+    query.bind<":id">(id);
 
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to load league index for realm='{}': {}", realm, message);
         return {};
     }
 
     if (!query.next()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to read league index for realm='{}': {}", realm, message);
         return {};
     }
 
     poe::StashWrapper wrapper;
-    const QByteArray data = query.value(0).toByteArray();
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const QByteArray data = query.blob(0);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing character wrapper");
         return {};
@@ -231,28 +691,25 @@ std::optional<poe::StashTab> UserStore::getStash(const QString &realm,
 
 void UserStore::loadLeagueList(const QString &realm)
 {
-    const QString statement{"SELECT data FROM indexes WHERE name = 'leagues' AND realm = :realm"};
-
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":realm", realm);
+    sql::Query<"SELECT data FROM indexes WHERE name = 'leagues' AND realm = :realm"> query(db);
+    query.bind<":realm">(realm);
 
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to load league index for realm='{}': {}", realm, message);
         return;
     }
 
     if (!query.next()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to read league index for realm='{}': {}", realm, message);
         return;
     }
 
     poe::LeagueListWrapper wrapper;
-    const QByteArray data = query.value(0).toByteArray();
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const QByteArray data = query.blob(0);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing league list");
         return;
@@ -262,29 +719,27 @@ void UserStore::loadLeagueList(const QString &realm)
 
 void UserStore::loadCharacterList(const QString &realm)
 {
-    const QString statement{"SELECT data FROM indexes"
-                            " WHERE name = 'characters' AND realm = :realm"};
-
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":realm", realm);
+    sql::Query<"SELECT data FROM indexes"
+               " WHERE name = 'characters' AND realm = :realm">
+        query(db);
+    query.bind<":realm">(realm);
 
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to load character index for {} realm: {}", realm, message);
         return;
     }
 
     if (!query.next()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to read character index for {} realm: {}", realm, message);
         return;
     }
 
     poe::CharacterListWrapper wrapper;
-    const QByteArray data = query.value(0).toByteArray();
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const QByteArray data = query.blob(0);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing character list");
         return;
@@ -294,52 +749,51 @@ void UserStore::loadCharacterList(const QString &realm)
 
 void UserStore::loadCharacters(const QString &realm, const QString &league)
 {
-    const QString statement{"SELECT data FROM characters"
-                            " WHERE realm = :realm AND league = :league"};
-
     // Build the query.
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":realm", realm);
-    query.bindValue(":league", league);
+    sql::Query<"SELECT data FROM characters"
+               " WHERE realm = :realm AND league = :league">
+        query(db);
+    query.bind<":realm">(realm);
+    query.bind<":league">(league);
 
     // Run the query.
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to get characters in {}/{}: {}", realm, league, message);
         return;
     }
 
-    // Parse and emit the results.
+    // Parse the results and emit them together.
+    std::vector<poe::Character> characters;
     while (query.next()) {
         poe::CharacterWrapper wrapper;
-        const QByteArray data = query.value(0).toByteArray();
-        const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+        const QByteArray data = query.blob(0);
+        const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
         if (!ok) {
             spdlog::error("UserData: error parsing character");
         } else if (!wrapper.character) {
             spdlog::error("UserData: character wrapper is empty");
         } else {
-            const poe::Character character = wrapper.character.value();
-            emit characterReady(std::move(character));
+            characters.push_back(std::move(wrapper.character.value()));
         }
     }
+    if (!characters.empty()) {
+        emit charactersReady(std::move(characters));
+    }
 }
 
 void UserStore::loadStashList(const QString &realm, const QString &league)
 {
-    const QString statement{"SELECT data FROM indexes"
-                            " WHERE name = 'stashes' AND realm = :realm AND league = :league"};
-
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":realm", realm);
-    query.bindValue(":league", league);
+    sql::Query<"SELECT data FROM indexes"
+               " WHERE name = 'stashes' AND realm = :realm AND league = :league">
+        query(db);
+    query.bind<":realm">(realm);
+    query.bind<":league">(league);
 
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to load stash index for {} league in {} realm: {}",
                       league,
                       realm,
@@ -348,7 +802,7 @@ void UserStore::loadStashList(const QString &realm, const QString &league)
     }
 
     if (!query.next()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to read stash index for {} league in {} realm: {}",
                       league,
                       realm,
@@ -357,8 +811,8 @@ void UserStore::loadStashList(const QString &realm, const QString &league)
     }
 
     poe::StashListWrapper wrapper;
-    const QByteArray data = query.value(0).toByteArray();
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const QByteArray data = query.blob(0);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing stash list");
         return;
@@ -368,43 +822,163 @@ void UserStore::loadStashList(const QString &realm, const QString &league)
 
 void UserStore::loadStashes(const QString &realm, const QString &league)
 {
-    const QString statement{"SELECT data FROM stashes WHERE"
-                            " realm = :realm AND"
-                            " league = :league"};
-
     // Build the query.
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":realm", realm);
-    query.bindValue(":league", league);
+    sql::Query<"SELECT id FROM stashes WHERE"
+               " realm = :realm AND"
+               " league = :league"
+               " ORDER BY stash_index, id">
+        query(db);
+    query.bind<":realm">(realm);
+    query.bind<":league">(league);
 
     // Run the query.
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to get stashes in {}/{}: {}", realm, league, message);
         return;
     }
 
-    // Parse and emit the results.
+    // Any load that is still running is now stale.
+    if (m_stashLoad) {
+        m_stashLoad->cancelled = true;
+    }
+
+    auto load = std::make_shared<StashLoad>();
     while (query.next()) {
-        poe::StashWrapper wrapper;
-        const QByteArray data = query.value(0).toByteArray();
-        const bool ok = json::parse_into(wrapper, data, JSON_MODE);
-        if (!ok) {
-            spdlog::error("UserStore: error parsing stash tab");
-        } else if (!wrapper.stash) {
-            spdlog::error("UserData: stash wrapper is empty");
+        load->ids.push_back(query.get<QString>(0));
+    }
+    load->stashes.resize(load->ids.size());
+    load->remaining = load->ids.size();
+    m_stashLoad = load;
+
+    if (load->ids.empty()) {
+        return;
+    }
+
+    // Workers take every n-th stash rather than a contiguous block, so that
+    // large and small tabs are spread evenly between them.
+    const size_t worker_count = std::min<size_t>(readPool().maxThreadCount(), load->ids.size());
+    spdlog::debug("UserStore: loading {} stashes in {}/{} with {} workers",
+                  load->ids.size(),
+                  realm,
+                  league,
+                  worker_count);
+    for (size_t worker = 0; worker < worker_count; ++worker) {
+        readPool().start([this, load, worker, worker_count]() {
+            loadStashRange(load, worker, worker_count);
+        });
+    }
+}
+
+void UserStore::loadStashRange(const std::shared_ptr<StashLoad> &load, size_t first, size_t stride)
+{
+    // This runs on the read pool.
+    auto db = getReadDatabase();
+    sql::Query<"SELECT data FROM stashes WHERE id = :id"> query(db);
+
+    for (size_t i = first; i < load->ids.size(); i += stride) {
+        if (load->cancelled) {
+            return;
+        }
+
+        const QString &id = load->ids[i];
+        std::optional<poe::StashTab> stash;
+
+        query.bind<":id">(id);
+        if (!query.exec()) {
+            const QString message = query.errorText();
+            spdlog::error("UserStore: failed to get stash '{}': {}", id, message);
+        } else if (!query.next()) {
+            spdlog::error("UserStore: stash '{}' is missing", id);
         } else {
-            emit stashReady(wrapper.stash.value());
+            poe::StashWrapper wrapper;
+            const QByteArray data = query.blob(0);
+            const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
+            if (!ok) {
+                spdlog::error("UserStore: error parsing stash tab");
+            } else if (!wrapper.stash) {
+                spdlog::error("UserData: stash wrapper is empty");
+            } else {
+                stash = std::move(wrapper.stash);
+            }
         }
+        query.finish();
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, load, i, stash = std::move(stash)]() mutable {
+                deliverStash(load, i, std::move(stash));
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+void UserStore::deliverStash(const std::shared_ptr<StashLoad> &load,
+                             size_t index,
+                             std::optional<poe::StashTab> stash)
+{
+    // Ignore results from a load that has been superseded.
+    if (load != m_stashLoad) {
+        return;
+    }
+
+    load->stashes[index] = std::move(stash);
+    if (--load->remaining > 0) {
+        return;
+    }
+
+    // Emit the whole league at once, so the tree inserts it as one batch.
+    std::vector<poe::StashTab> stashes;
+    stashes.reserve(load->stashes.size());
+    for (auto &slot : load->stashes) {
+        if (slot) {
+            stashes.push_back(std::move(slot.value()));
+        }
+    }
+    spdlog::debug("UserStore: finished loading {} stashes", stashes.size());
+
+    // Reset first in case a receiver starts a new load.
+    m_stashLoad.reset();
+    emit stashesReady(std::move(stashes));
+}
+
+QStringList UserStore::searchItems(const QString &text, int limit)
+{
+    const QString expression = getMatchExpression(text);
+    if (expression.isEmpty()) {
+        return {};
+    }
+
+    // Matches in the item name are weighted above the type lines,
+    // which are weighted above the mod text.
+    auto db = getThreadLocalDatabase();
+    sql::Query<"SELECT search_rows.item_id FROM search_items"
+               " JOIN search_rows ON search_rows.rowid = search_items.rowid"
+               " WHERE search_items MATCH :expression"
+               " ORDER BY bm25(search_items, 10.0, 5.0, 5.0, 1.0)"
+               " LIMIT :limit">
+        query(db);
+    query.bind<":expression">(expression);
+    query.bind<":limit">(limit);
+
+    if (!query.exec()) {
+        const QString message = query.errorText();
+        spdlog::error("UserStore: failed to search items for '{}': {}", expression, message);
+        return {};
+    }
+
+    QStringList ids;
+    while (query.next()) {
+        ids.append(query.get<QString>(0));
     }
+    return ids;
 }
 
 void UserStore::storeLeagueListData(const QString &realm, const QByteArray &data)
 {
     poe::LeagueListWrapper wrapper;
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing league list wrapper.");
         return;
@@ -416,7 +990,7 @@ void UserStore::storeLeagueListData(const QString &realm, const QByteArray &data
 void UserStore::storeCharacterListData(const QString &realm, const QByteArray &data)
 {
     poe::CharacterListWrapper wrapper;
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing character list wrapper.");
         return;
@@ -430,7 +1004,7 @@ void UserStore::storeStashListData(const QString &realm,
                                    const QByteArray &data)
 {
     poe::StashListWrapper wrapper;
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserStore: error parsing stash list wrapper.");
         return;
@@ -442,9 +1016,10 @@ void UserStore::storeStashListData(const QString &realm,
 void UserStore::storeCharacterData(const QString &realm, const QString &name, const QByteArray &data)
 {
     poe::CharacterWrapper wrapper;
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
+    const bool ok = json::parse_into<JSON_MODE>(wrapper, data);
     if (!ok) {
         spdlog::error("UserData: error parsing character data before saving");
+        storeUndecodedCharacter(realm, name, data);
         return;
     }
     if (!wrapper.character) {
@@ -463,29 +1038,32 @@ void UserStore::storeCharacterData(const QString &realm, const QString &name, co
         spdlog::warn("UserStore: using character name '{}' but found '{}'", name, character.name);
     }
 
-    const QString statement = "INSERT OR REPLACE INTO characters"
-                              " (id, name, realm, league, timestamp, data)"
-                              " VALUES"
-                              " (:id, :name, :realm, :league, :timestamp, :data)";
-
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":id", character.id);
-    query.bindValue(":name", name);
-    query.bindValue(":realm", realm);
-    query.bindValue(":league", character.league.value_or(""));
-    query.bindValue(":timestampe", QDateTime::currentMSecsSinceEpoch());
-    query.bindValue(":data", data);
-
-    if (query.exec()) {
+    const QString league = character.league.value_or("");
+    if (insertCharacter(db, character.id, name, realm, league, data)) {
+        std::vector<const poe::Item *> items;
+        collectItems(character, items);
+        updateSearchIndex(character.id, items);
         emit characterReady(character);
-    } else {
-        const QString message = query.lastError().text();
-        spdlog::error("UserStore: failed to update character '{}' in {} realm: {}",
-                      name,
-                      realm,
-                      message);
+    }
+}
+
+// Keeps a character that could not be decoded, so that it doesn't have to be
+// fetched again once a later version can decode it.
+void UserStore::storeUndecodedCharacter(const QString &realm,
+                                        const QString &name,
+                                        const QByteArray &data)
+{
+    CharacterHeaderWrapper wrapper;
+    if (!json::parse_into<json::Mode::Permissive>(wrapper, data) || !wrapper.character) {
+        spdlog::error("UserStore: unable to save undecodable character '{}'", name);
+        return;
+    }
+    const auto &character = wrapper.character.value();
+    auto db = getThreadLocalDatabase();
+    const QString league = character.league.value_or("");
+    if (insertCharacter(db, character.id, name, realm, league, data)) {
+        spdlog::warn("UserStore: saved character '{}' without decoding it", name);
     }
 }
 
@@ -495,18 +1073,28 @@ void UserStore::storeStashData(const QString &realm,
                                const QString &substash_id,
                                const QByteArray &data)
 {
-    poe::StashWrapper wrapper;
-    const bool ok = json::parse_into(wrapper, data, JSON_MODE);
-    if (!ok) {
-        spdlog::error("UserStore: error parsing stash before saving.");
+    // The payload is scanned once. Each item is decoded from its slice, and the
+    // same slices are hashed for the history delta.
+    arena::ParseArena arena(data.size());
+    poe::LazyStashWrapper scan;
+    poe::StashTab stash;
+    std::vector<poe::LazyItem> lazy_items;
+    const bool scanned = json::parse_into<JSON_MODE>(scan, data);
+    if (scanned && !scan.stash) {
+        spdlog::error("UserStore: recieved empty stash");
         return;
     }
-    if (!wrapper.stash) {
-        spdlog::error("UserStore: recieved empty stash");
+    if (!scanned || !poe::decodeStash<JSON_MODE>(data, scan.stash.value(), stash, lazy_items)) {
+        spdlog::error("UserStore: error parsing stash for {} realm in {} league with "
+                      "stash_id='{}' substash_id='{}'",
+                      realm,
+                      league,
+                      stash_id,
+                      substash_id);
+        storeUndecodedStash(realm, league, data);
         return;
     }
 
-    const auto &stash = wrapper.stash.value();
     const QString id = substash_id.isEmpty() ? stash_id : substash_id;
     const QString parent_id = substash_id.isEmpty() ? "" : stash_id;
 
@@ -522,70 +1110,121 @@ void UserStore::storeStashData(const QString &realm,
         }
     }
 
-    const QString statement
-        = "INSERT OR REPLACE INTO stashes"
-          " (id, parent, name, type, stash_index, realm, league, timestamp, data)"
-          " VALUES"
-          " (:id, :parent, :name, :type, :stash_index, :realm, :league, :timestampe, :data)";
+    auto db = getThreadLocalDatabase();
+
+    // The snapshot, its search index and its history are written in one
+    // transaction, so they can't get out of step when one of them fails.
+    if (!db.transaction()) {
+        const QString message = db.lastError().text();
+        spdlog::error("UserStore: failed to begin update of stash '{}': {}", stash.id, message);
+        return;
+    }
+
+    // The delta has to be computed before the previous snapshot is replaced.
+    std::vector<history::StashItem> history_items;
+    history_items.reserve(lazy_items.size());
+    for (size_t i = 0; i < lazy_items.size(); ++i) {
+        const auto &item_id = stash.items.value()[i].id;
+        if (item_id) {
+            history_items.push_back({item_id.value(), lazy_items[i].json()});
+        }
+    }
+    history::StashDelta delta;
+    const bool has_delta = history::computeDelta(db, stash.id, history_items, delta);
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    std::vector<const poe::Item *> items;
+    if (stash.items) {
+        collectItems(stash.items.value(), items);
+    }
+    const bool ok = insertStash(db, stash, realm, league, timestamp, data)
+                    && writeSearchIndex(db, stash.id, items)
+                    && (!has_delta || history::writeDelta(db, delta, timestamp));
+    if (!ok) {
+        db.rollback();
+        return;
+    }
+    if (!db.commit()) {
+        const QString message = db.lastError().text();
+        spdlog::error("UserStore: failed to commit stash '{}': {}", stash.id, message);
+        db.rollback();
+        return;
+    }
+    emit stashReady(stash);
+}
+
+// Keeps a stash that could not be decoded, so that it doesn't have to be
+// fetched again once a later version can decode it. Search and history only
+// need the lazy scan, so they are still kept up to date.
+void UserStore::storeUndecodedStash(const QString &realm,
+                                    const QString &league,
+                                    const QByteArray &data)
+{
+    arena::ParseArena arena(data.size());
+
+    poe::LazyStashWrapper wrapper;
+    if (!json::parse_into<poe::LAZY_JSON_MODE>(wrapper, data) || !wrapper.stash) {
+        spdlog::error("UserStore: unable to save undecodable stash");
+        return;
+    }
+    const auto &stash = wrapper.stash.value();
 
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":id", stash.id);
-    query.bindValue(":parent", stash.parent.value_or(""));
-    query.bindValue(":name", stash.name);
-    query.bindValue(":type", stash.type);
-    if (stash.index) {
-        query.bindValue(":stash_index", stash.index.value());
-    } else {
-        query.bindValue(":stash_index", "");
-    }
-    query.bindValue(":realm", realm);
-    query.bindValue(":league", league);
-    query.bindValue(":timestamp", QDateTime::currentMSecsSinceEpoch());
-    query.bindValue(":data", data);
-
-    if (query.exec()) {
-        emit stashReady(stash);
-    } else {
-        const QString message = query.lastError().text();
-        spdlog::error("UserStore: failed to update stash for {} realm in {} league with "
-                      "stash_id='{}' substash_id='{}': {}",
-                      realm,
-                      league,
-                      stash_id,
-                      substash_id,
-                      message);
+    if (!db.transaction()) {
+        const QString message = db.lastError().text();
+        spdlog::error("UserStore: failed to begin update of stash '{}': {}", stash.id, message);
+        return;
+    }
+
+    std::vector<poe::LazyItem> items;
+    if (stash.items) {
+        items = poe::toLazyItems(data, stash.items.value());
     }
+    history::StashDelta delta;
+    const bool has_delta = history::computeDelta(db, stash.id, history::stashItems(items), delta);
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    const bool ok = insertStash(db, stash, realm, league, timestamp, data)
+                    && indexStash(db, stash.id, data)
+                    && (!has_delta || history::writeDelta(db, delta, timestamp));
+    if (!ok) {
+        db.rollback();
+        return;
+    }
+    if (!db.commit()) {
+        const QString message = db.lastError().text();
+        spdlog::error("UserStore: failed to commit stash '{}': {}", stash.id, message);
+        db.rollback();
+        return;
+    }
+    spdlog::warn("UserStore: saved stash '{}' without decoding it", stash.id);
 }
 
 QByteArray UserStore::getIndex(const QString &name, const QString &realm, const QString &league)
 {
-    const QString statement{"SELECT data FROM indexes WHERE"
-                            " name = :name AND"
-                            " realm = :realm AND"
-                            " league = :league"};
-
     spdlog::info("GET_INDEX: {}, {}, {}", name, realm, league);
 
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":name", name);
-    query.bindValue(":realm", realm);
-    query.bindValue(":league", league);
+    sql::Query<"SELECT data FROM indexes WHERE"
+               " name = :name AND"
+               " realm = :realm AND"
+               " league = :league">
+        query(db);
+    query.bind<":name">(name);
+    query.bind<":realm">(realm);
+    query.bind<":league">(league);
 
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to get {} index: {}", name, message);
         return {};
     }
     if (!query.next()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to read {} index: {}", name, message);
         return {};
     }
-    return query.value(0).toByteArray();
+    return query.blob(0);
 }
 
 void UserStore::updateIndex(const QString &name,
@@ -598,28 +1237,71 @@ void UserStore::updateIndex(const QString &name,
         return;
     }
 
-    const QString statement{"INSERT OR REPLACE INTO indexes"
-                            " (name, realm, league, timestamp, data)"
-                            " VALUES"
-                            " (:name, :realm, :league, :timestamp, :data)"};
-
-    spdlog::trace("UserStore: updating {} index: '{}'", name, statement);
+    spdlog::trace("UserStore: updating {} index", name);
 
     auto db = getThreadLocalDatabase();
-    auto query = QSqlQuery(db);
-    query.prepare(statement);
-    query.bindValue(":name", name);
-    query.bindValue(":realm", realm);
-    query.bindValue(":league", league);
-    query.bindValue(":timestamp", QDateTime::currentMSecsSinceEpoch());
-    query.bindValue(":data", data);
+    sql::Query<"INSERT OR REPLACE INTO indexes"
+               " (name, realm, league, timestamp, data)"
+               " VALUES"
+               " (:name, :realm, :league, :timestamp, :data)">
+        query(db);
+    query.bind<":name">(name);
+    query.bind<":realm">(realm);
+    query.bind<":league">(league);
+    query.bind<":timestamp">(QDateTime::currentMSecsSinceEpoch());
+    query.bind<":data">(data);
 
     if (!query.exec()) {
-        const QString message = query.lastError().text();
+        const QString message = query.errorText();
         spdlog::error("UserStore: failed to update {} index: {}", name, message);
     }
 }
 
+bool UserStore::updateSearchIndex(const QString &owner, const std::vector<const poe::Item *> &items)
+{
+    auto db = getThreadLocalDatabase();
+    if (!db.transaction()) {
+        const QString message = db.lastError().text();
+        spdlog::error("UserStore: failed to begin search index update for {}: {}", owner, message);
+        return false;
+    }
+    if (!writeSearchIndex(db, owner, items)) {
+        db.rollback();
+        return false;
+    }
+    if (!db.commit()) {
+        const QString message = db.lastError().text();
+        spdlog::error("UserStore: failed to commit search index for {}: {}", owner, message);
+        db.rollback();
+        return false;
+    }
+    return true;
+}
+
+std::vector<history::ItemEvent> UserStore::getItemHistory(const QStringList &stash_ids,
+                                                          qint64 from,
+                                                          qint64 to,
+                                                          std::optional<history::EventType> type)
+{
+    auto db = getThreadLocalDatabase();
+    return history::readEvents(db, stash_ids, from, to, type);
+}
+
+void UserStore::compactItemHistory()
+{
+    // This runs on the background pool.
+    auto db = getThreadLocalDatabase();
+    if (!db.transaction()) {
+        const QString message = db.lastError().text();
+        spdlog::error("UserStore: failed to begin history compaction: {}", message);
+        return;
+    }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (!history::compact(db, now, HISTORY_POLICY) || !db.commit()) {
+        db.rollback();
+    }
+}
+
 QString UserStore::getPath(const QString &username)
 {
     const QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
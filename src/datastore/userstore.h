@@ -4,6 +4,7 @@
 #pragma once
 
 #include "datastore.h"
+#include "itemhistory.h"
 #include "poe/types/character.h"
 #include "poe/types/league.h"
 #include "poe/types/stashtab.h"
@@ -14,6 +15,8 @@
 #include <QSqlDatabase>
 #include <QString>
 
+#include <memory>
+#include <optional>
 #include <vector>
 
 class UserStore : public DataStore
@@ -21,6 +24,7 @@ class UserStore : public DataStore
     Q_OBJECT
 public:
     explicit UserStore(const QString &username, QObject *parent = nullptr);
+    ~UserStore() override;
 
     void connectTo(PoeClient &client);
 
@@ -39,18 +43,37 @@ public:
 
     void loadLeagueList(const QString &realm);
     void loadCharacterList(const QString &realm);
+    // Loads every character in a league and emits them together in
+    // charactersReady().
     void loadCharacters(const QString &realm, const QString &league);
     void loadStashList(const QString &realm, const QString &league);
+    // Loads every stash in a league on the read pool and emits them together
+    // in stashesReady(), in stash index order. Starting a new load cancels the
+    // previous one.
     void loadStashes(const QString &realm, const QString &league);
 
+    // Returns the ids of items matching the search text, best matches first.
+    // Bare words are prefix matches and double-quoted text is a phrase match.
+    QStringList searchItems(const QString &text, int limit);
+
+    // Returns item events in [from, to) for the given stashes, or for every
+    // stash if the list is empty. For example, the items that left a set of
+    // shop tabs are the removed events for those tabs.
+    std::vector<history::ItemEvent> getItemHistory(const QStringList &stash_ids,
+                                                   qint64 from,
+                                                   qint64 to,
+                                                   std::optional<history::EventType> type);
+
 signals:
     void leagueListReady(std::vector<poe::League> leagueList);
     void characterListReady(std::vector<poe::Character> characterList);
     void characterReady(poe::Character character);
+    void charactersReady(std::vector<poe::Character> characters);
     void stashListReady(const QString &realm,
                         const QString &league,
                         std::vector<poe::StashTab> stashList);
     void stashReady(poe::StashTab stash);
+    void stashesReady(std::vector<poe::StashTab> stashes);
 
 public slots:
     void storeLeagueListData(const QString &realm, const QByteArray &data);
@@ -68,11 +91,30 @@ public slots:
                         const QByteArray &data);
 
 private:
+    bool createInitialSchema();
+    bool createSearchSchema();
+    bool createHistorySchema();
+
     QByteArray getIndex(const QString &name, const QString &realm, const QString &league);
     void updateIndex(const QString &name,
                      const QString &realm,
                      const QString &league,
                      const QByteArray &data);
 
+    struct StashLoad;
+
+    void loadStashRange(const std::shared_ptr<StashLoad> &load, size_t first, size_t stride);
+    void deliverStash(const std::shared_ptr<StashLoad> &load,
+                      size_t index,
+                      std::optional<poe::StashTab> stash);
+
+    void storeUndecodedCharacter(const QString &realm, const QString &name, const QByteArray &data);
+    void storeUndecodedStash(const QString &realm, const QString &league, const QByteArray &data);
+
+    bool updateSearchIndex(const QString &owner, const std::vector<const poe::Item *> &items);
+    void compactItemHistory();
+
     static QString getPath(const QString &username);
+
+    std::shared_ptr<StashLoad> m_stashLoad;
 };
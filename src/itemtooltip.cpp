@@ -57,7 +57,7 @@ namespace {
 
 } // namespace
 
-ItemTooltip::ItemTooltip(const ItemData &item, QObject *parent)
+ItemTooltip::ItemTooltip(const ItemData &item, const ItemData::Details &details, QObject *parent)
     : QObject(parent)
 {
     const bool single_line = item.name.isEmpty();
@@ -113,30 +113,30 @@ ItemTooltip::ItemTooltip(const ItemData &item, QObject *parent)
     }
 
     m_separatorUrl = "qrc:/images/separators/Separator" + frame_name + ".png";
-    m_propertiesText1 = item.propertiesText1;
-    m_propertiesText2 = item.propertiesText2;
-    m_requirementsTest = item.requirementsText;
+    m_propertiesText1 = details.propertiesText1;
+    m_propertiesText2 = details.propertiesText2;
+    m_requirementsTest = details.requirementsText;
 
     // Implict modifiers get their own section.
-    if (!item.implicitMods.isEmpty()) {
-        m_implicitsText = renderModList(item.implicitMods, IMPLICIT_MODS_COLOR);
+    if (!details.implicitMods.isEmpty()) {
+        m_implicitsText = renderModList(details.implicitMods, IMPLICIT_MODS_COLOR);
     }
 
     // Enchantments get their own section.
-    if (!item.enchantMods.isEmpty()) {
-        m_enchantmentsText = renderModList(item.enchantMods, ENCHANTED_MODS_COLOR);
+    if (!details.enchantMods.isEmpty()) {
+        m_enchantmentsText = renderModList(details.enchantMods, ENCHANTED_MODS_COLOR);
     }
 
     // Fractured, explicit, and crafted modifiers appear in the same section.
     QStringList modifiers;
-    if (!item.fracturedMods.isEmpty()) {
-        modifiers.append(renderModList(item.fracturedMods, FRACTURED_MODS_COLOR));
+    if (!details.fracturedMods.isEmpty()) {
+        modifiers.append(renderModList(details.fracturedMods, FRACTURED_MODS_COLOR));
     }
-    if (!item.explicitMods.isEmpty()) {
-        modifiers.append(renderModList(item.explicitMods, EXPLICIT_MODS_COLOR));
+    if (!details.explicitMods.isEmpty()) {
+        modifiers.append(renderModList(details.explicitMods, EXPLICIT_MODS_COLOR));
     }
-    if (!item.craftedMods.isEmpty()) {
-        modifiers.append(renderModList(item.craftedMods, CRAFTED_MODS_COLOR));
+    if (!details.craftedMods.isEmpty()) {
+        modifiers.append(renderModList(details.craftedMods, CRAFTED_MODS_COLOR));
     }
     m_modifiersText = modifiers.join("<br>");
 
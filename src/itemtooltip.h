@@ -36,7 +36,9 @@ class ItemTooltip : public QObject
     Q_PROPERTY(QString separatorUrl MEMBER m_separatorUrl CONSTANT)
 
 public:
-    explicit ItemTooltip(const ItemData &item, QObject *parent = nullptr);
+    explicit ItemTooltip(const ItemData &item,
+                         const ItemData::Details &details,
+                         QObject *parent = nullptr);
 
 private:
     QString renderDisplayText(const ItemData &item);
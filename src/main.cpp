@@ -4,6 +4,7 @@
 #include "app.h"
 
 #include "util/spdlog_qt.h"
+#include "util/unknownkeys.h"
 
 static_assert(ACQUISITION_USE_SPDLOG);
 
@@ -74,5 +75,13 @@ int main(int argc, char *argv[])
 
     engine.load(QUrl("qrc:/qt/qml/Acquisition/Main.qml"));
 
-    return app.exec();
+    const int result = app.exec();
+
+    // Summarize what the API sent that this version doesn't read yet.
+    for (const auto &[type, keys] : json::unknownKeys()) {
+        for (const auto &[key, count] : keys) {
+            spdlog::info("json: skipped unknown key '{}' in {} {} times", key, type, count);
+        }
+    }
+    return result;
 }
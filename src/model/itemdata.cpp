@@ -3,19 +3,40 @@
 
 #include "model/itemdata.h"
 
+#include "util/intern.h"
+#include "util/propertyvalue.h"
 #include "util/spdlog_qt.h"
 
 static_assert(ACQUISITION_USE_SPDLOG);
 
-const std::vector<ItemData::Column> ItemData::Columns = ItemData::createColumnsInfo();
-const int ItemData::ColumnCount = ItemData::Columns.size();
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+namespace {
+
+    // Stores a number in a field that may be narrower than an int, saturating
+    // at the limits of the field's type.
+    template<typename T>
+    void store(T &field, int value)
+    {
+        constexpr int min = std::numeric_limits<T>::min();
+        constexpr int max = std::numeric_limits<T>::max();
+        field = static_cast<T>(std::clamp(value, min, max));
+    }
+
+} // namespace
 
+// Text that repeats between items is interned, so that every item with the
+// same base type or icon shares one copy of it. Names of rare and
+// unique items and anything that includes them are left alone.
 ItemData::ItemData(const poe::Item &item)
 {
     id = item.id.value_or("");
     name = item.name;
-    typeLine = item.typeLine;
-    baseType = item.baseType;
+    typeLine = intern::string(item.typeLine);
+    baseType = intern::string(item.baseType);
     frameType = item.frameType;
 
     if (name.isEmpty()) {
@@ -24,29 +45,10 @@ ItemData::ItemData(const poe::Item &item)
         prettyName = name + " " + typeLine;
     }
 
-    const auto propertySections = ItemData::formatProperties(item);
-
-    if (propertySections.size() > 0) {
-        propertiesText1 = propertySections.front();
-    }
-    if (propertySections.size() > 1) {
-        propertiesText2 = propertySections.back();
-    }
-    if (propertySections.size() > 2) {
-        spdlog::error("Encountered a item with {} property sections", propertySections.size());
-    }
-
-    requirementsText = ItemData::formatRequirements(item);
-
-    implicitMods = ItemData::getMods(item.implicitMods);
-    enchantMods = ItemData::getMods(item.enchantMods);
-    fracturedMods = ItemData::getMods(item.fracturedMods);
-    explicitMods = ItemData::getMods(item.explicitMods);
-    craftedMods = ItemData::getMods(item.craftedMods);
-
-    w = item.w;
-    h = item.h;
-    icon = item.icon;
+    store(w, static_cast<int>(item.w));
+    store(h, static_cast<int>(item.h));
+    store(itemLevel, item.itemLevel.value_or(item.ilvl));
+    icon = intern::string(item.icon);
 
     loadSockets(item, *this);
     loadProperties(item, *this);
@@ -81,7 +83,7 @@ ItemData::ItemData(const poe::Item &item)
     crafted = item.craftedMods.has_value();
     veiled = item.veiled.value_or(false);
     forseeing = item.foreseeing.value_or(false);
-    talismanTier = item.talismanTier.value_or(0);
+    store(talismanTier, item.talismanTier.value_or(0));
     //int stored_experience;
     stackSize = item.stackSize.value_or(0);
     //QString alternate_art;
@@ -114,8 +116,17 @@ ItemData::SocketData &ItemData::sockets()
     return socketData.value();
 };
 
+ItemData::RareData &ItemData::rare()
+{
+    if (!rareData) {
+        rareData = std::make_unique<RareData>();
+    }
+    return *rareData;
+}
+
 ItemData::HeistData &ItemData::heist()
 {
+    auto &heistData = rare().heistData;
     if (!heistData) {
         heistData = HeistData{};
     }
@@ -132,9 +143,11 @@ void ItemData::loadSockets(const poe::Item &item, ItemData &i)
     SocketData sockets{};
     for (const auto& socket : item.sockets.value()) {
         const unsigned int group = socket.group;
-        while (group >= sockets.socketGroups.size()) {
-            sockets.socketGroups.push_back(SocketGroup{});
+        if (group >= SocketData::MaxGroups) {
+            spdlog::error("Unexpected socket group in {} {}: {}", item.name, item.typeLine, group);
+            continue;
         }
+        sockets.groupCount = std::max(sockets.groupCount, static_cast<quint8>(group + 1));
         const QString& colour = socket.sColour.value_or("");
         // clang-format off
         if      (colour == "R")  { ++sockets.redSockets;   ++sockets.socketGroups[group].red;   }
@@ -154,15 +167,197 @@ void ItemData::loadSockets(const poe::Item &item, ItemData &i)
     i.socketData = std::move(sockets);
 }
 
+struct ItemData::PropertyTarget
+{
+    ItemData &item;
+    float physicalHit{0.0};
+    float elementalHit{0.0};
+    float chaosHit{0.0};
+};
+
+struct ItemData::PropertyRule
+{
+    enum Parser {
+        None,
+        Ignore,
+        Int,
+        LeadingInt,
+        Percent,
+        Fraction,
+        Float,
+        FloatPercent,
+        Average,
+        Text
+    };
+    enum Section : unsigned { Properties = 1 << 0, Requirements = 1 << 1 };
+
+    // One more than the largest poe::ItemPropertyType.
+    static constexpr size_t TableSize = static_cast<size_t>(poe::ItemPropertyType::MoreScarabs)
+                                        + 1;
+
+    Parser parser{None};
+    unsigned sections{0}; // Where this property is allowed to appear.
+    void (*setInt)(PropertyTarget &, int){nullptr};
+    void (*setDenominator)(PropertyTarget &, int){nullptr};
+    float &(*floatField)(PropertyTarget &){nullptr};
+    QString &(*textField)(PropertyTarget &){nullptr};
+};
+
+// Every typed value that loadProperties and loadRequirements understand is
+// described by one entry in this table, which is indexed by the type itself.
+// Weapon hits are collected in the target until the attack speed is known.
+const ItemData::PropertyRule *ItemData::findPropertyRule(poe::ItemPropertyType type)
+{
+    using Type = poe::ItemPropertyType;
+    using Rule = PropertyRule;
+    using Target = PropertyTarget;
+
+    constexpr unsigned Properties = Rule::Properties;
+    constexpr unsigned Requirements = Rule::Requirements;
+    constexpr unsigned Anywhere = Rule::Properties | Rule::Requirements;
+
+    // clang-format off
+    static constexpr std::pair<Type, Rule> entries[] = {
+        {Type::Level,                   {Rule::LeadingInt,   Properties,   [](Target &t, int v) { store(t.item.gemLevel, v); }}},
+        {Type::Quality,                 {Rule::Percent,      Properties,   [](Target &t, int v) { store(t.item.quality, v); }}},
+        {Type::PhysicalDamage,          {Rule::Average,      Properties,   nullptr, nullptr, [](Target &t) -> float & { return t.physicalHit; }}},
+        {Type::ElementalDamage,         {Rule::Average,      Properties,   nullptr, nullptr, [](Target &t) -> float & { return t.elementalHit; }}},
+        {Type::ChaosDamage,             {Rule::Average,      Properties,   nullptr, nullptr, [](Target &t) -> float & { return t.chaosHit; }}},
+        {Type::CriticalStrikeChance,    {Rule::FloatPercent, Properties,   nullptr, nullptr, [](Target &t) -> float & { return t.item.weapon().criticalChance; }}},
+        {Type::AttacksPerSecond,        {Rule::Float,        Properties,   nullptr, nullptr, [](Target &t) -> float & { return t.item.weapon().attacksPerSecond; }}},
+        {Type::WeaponRange,             {Rule::Float,        Properties,   nullptr, nullptr, [](Target &t) -> float & { return t.item.weapon().weaponRange; }}},
+        {Type::ChanceToBlock,           {Rule::Percent,      Properties,   [](Target &t, int v) { store(t.item.armour().block, v); }}},
+        {Type::Armour,                  {Rule::Int,          Properties,   [](Target &t, int v) { store(t.item.armour().armour, v); }}},
+        {Type::EvasionRating,           {Rule::Int,          Properties,   [](Target &t, int v) { store(t.item.armour().evasionRating, v); }}},
+        {Type::EnergyShield,            {Rule::Int,          Properties,   [](Target &t, int v) { store(t.item.armour().energyShield, v); }}},
+        {Type::Ward,                    {Rule::Int,          Properties,   [](Target &t, int v) { store(t.item.armour().ward, v); }}},
+        {Type::StackSize,               {Rule::Fraction,     Properties,   [](Target &t, int v) { store(t.item.stackSize, v); },
+                                                                           [](Target &t, int v) { store(t.item.stackSizeMax, v); }}},
+        {Type::WingsRevealed,           {Rule::Fraction,     Properties,   [](Target &t, int v) { store(t.item.heist().wingsRevealed, v); },
+                                                                           [](Target &t, int v) { store(t.item.heist().wings, v); }}},
+        {Type::EscapeRoutesRevealed,    {Rule::Fraction,     Properties,   [](Target &t, int v) { store(t.item.heist().escapeRoutesRevealed, v); },
+                                                                           [](Target &t, int v) { store(t.item.heist().escapeRoutes, v); }}},
+        {Type::RewardRoomsRevealed,     {Rule::Fraction,     Properties,   [](Target &t, int v) { store(t.item.heist().rewardRoomsRevealed, v); },
+                                                                           [](Target &t, int v) { store(t.item.heist().rewardRooms, v); }}},
+        // Heist requirements can appear in both the item properties and the item requirements.
+        {Type::LockpickingLevel,        {Rule::Int,          Anywhere,     [](Target &t, int v) { store(t.item.heist().lockpickingLevel, v); }}},
+        {Type::BruteForceLevel,         {Rule::Int,          Anywhere,     [](Target &t, int v) { store(t.item.heist().bruteForceLevel, v); }}},
+        {Type::PerceptionLevel,         {Rule::Int,          Anywhere,     [](Target &t, int v) { store(t.item.heist().perceptionLevel, v); }}},
+        {Type::DemolutionLevel,         {Rule::Int,          Anywhere,     [](Target &t, int v) { store(t.item.heist().demolutionLevel, v); }}},
+        {Type::CounterThaumaturgyLevel, {Rule::Int,          Anywhere,     [](Target &t, int v) { store(t.item.heist().counterThaumaturgyLevel, v); }}},
+        {Type::TrapDisarmamentLevel,    {Rule::Int,          Anywhere,     [](Target &t, int v) { store(t.item.heist().trapDisarmamentLevel, v); }}},
+        {Type::AgilityLevel,            {Rule::Int,          Anywhere,     [](Target &t, int v) { store(t.item.heist().agilityLevel, v); }}},
+        {Type::DeceptionLevel,          {Rule::Int,          Anywhere,     [](Target &t, int v) { store(t.item.heist().deceptionLevel, v); }}},
+        {Type::EngineeringLevel,        {Rule::Int,          Anywhere,     [](Target &t, int v) { store(t.item.heist().engineeringLevel, v); }}},
+        // Requirements.
+        {Type::RequiredLevel,           {Rule::Int,          Requirements, [](Target &t, int v) { store(t.item.requiredLevel, v); }}},
+        {Type::RequiredStrength,        {Rule::Int,          Requirements, [](Target &t, int v) { store(t.item.requiredStrength, v); }}},
+        {Type::RequiredDexterity,       {Rule::Int,          Requirements, [](Target &t, int v) { store(t.item.requiredDexterity, v); }}},
+        {Type::RequiredIntelligence,    {Rule::Int,          Requirements, [](Target &t, int v) { store(t.item.requiredIntelligence, v); }}},
+        {Type::RequiredClass,           {Rule::Text,         Requirements, nullptr, nullptr, nullptr, [](Target &t) -> QString & { return t.item.rare().requiredClass; }}},
+        // Silently ignore all these properties:
+        {Type::MapTier,                 {Rule::Ignore,       Properties}},
+        {Type::ItemQuantity,            {Rule::Ignore,       Properties}},
+        {Type::ItemRarity,              {Rule::Ignore,       Properties}},
+        {Type::MonsterPackSize,         {Rule::Ignore,       Properties}},
+        {Type::AreaLevel,               {Rule::Ignore,       Properties}},
+        {Type::Radius,                  {Rule::Ignore,       Properties}},
+        {Type::HeistTarget,             {Rule::Ignore,       Properties}},
+        {Type::Limit,                   {Rule::Ignore,       Properties}},
+        {Type::MoreMaps,                {Rule::Ignore,       Properties}},
+        {Type::MoreScarabs,             {Rule::Ignore,       Properties}},
+        {Type::BeastiaryGenus,          {Rule::Ignore,       Properties}},
+        {Type::BeastiaryGroup,          {Rule::Ignore,       Properties}},
+        {Type::BeastieryFamily,         {Rule::Ignore,       Properties}},
+        {Type::UltimatumSacrifice,      {Rule::Ignore,       Properties}},
+        {Type::UltimatumReward,         {Rule::Ignore,       Properties}},
+        {Type::ValdoMapReward,          {Rule::Ignore,       Properties}},
+        {Type::ValdoMapConvert,         {Rule::Ignore,       Properties}},
+        {Type::ValdoShaperReward,       {Rule::Ignore,       Properties}},
+        {Type::ValdoElderReward,        {Rule::Ignore,       Properties}},
+        {Type::ValdoConquerorReward,    {Rule::Ignore,       Properties}},
+        {Type::ValdoUniqueReward,       {Rule::Ignore,       Properties}},
+        {Type::ValdoScarabReward,       {Rule::Ignore,       Properties}},
+        {Type::RitualVesselSource,      {Rule::Ignore,       Properties}},
+    };
+    // clang-format on
+
+    // The table is indexed by the type. Listing a type twice, or one that is
+    // larger than the table, stops the table from being a constant expression,
+    // so these mistakes are caught by the compiler.
+    static constexpr auto rules = [] {
+        std::array<Rule, PropertyRule::TableSize> table{};
+        for (const auto &[type, rule] : entries) {
+            const auto index = static_cast<size_t>(type);
+            if ((index >= table.size()) || (table[index].parser != Rule::None)) {
+                throw "invalid item property table";
+            }
+            table[index] = rule;
+        }
+        return table;
+    }();
+
+    const auto index = static_cast<size_t>(type);
+    if ((index >= rules.size()) || (rules[index].parser == Rule::None)) {
+        return nullptr;
+    }
+    return &rules[index];
+}
+
+bool ItemData::loadPropertyValue(const PropertyRule &rule,
+                                 const QString &value,
+                                 PropertyTarget &target)
+{
+    bool ok = false;
+    switch (rule.parser) {
+    case PropertyRule::None:
+        break;
+    case PropertyRule::Ignore:
+        ok = true;
+        break;
+    case PropertyRule::Int:
+        rule.setInt(target, propertyvalue::toInt(value, &ok));
+        break;
+    case PropertyRule::LeadingInt:
+        rule.setInt(target, propertyvalue::toLeadingInt(value, &ok));
+        break;
+    case PropertyRule::Percent:
+        rule.setInt(target, propertyvalue::toPercent(value, &ok));
+        break;
+    case PropertyRule::Fraction: {
+        int numerator = 0;
+        int denominator = 0;
+        ok = propertyvalue::toFraction(value, numerator, denominator);
+        if (ok) {
+            rule.setInt(target, numerator);
+            rule.setDenominator(target, denominator);
+        }
+        break;
+    }
+    case PropertyRule::Float:
+        rule.floatField(target) = propertyvalue::toFloat(value, &ok);
+        break;
+    case PropertyRule::FloatPercent:
+        rule.floatField(target) = propertyvalue::toFloatPercent(value, &ok);
+        break;
+    case PropertyRule::Average:
+        rule.floatField(target) = propertyvalue::toAverage(value, &ok);
+        break;
+    case PropertyRule::Text:
+        rule.textField(target) = intern::string(value);
+        ok = true;
+        break;
+    }
+    return ok;
+}
+
 void ItemData::loadProperties(const poe::Item &item, ItemData &i)
 {
     if (!item.properties) {
         return;
     }
 
-    float avg_phys_hit = 0;
-    float avg_ele_hit = 0;
-    float avg_chaos_hit = 0;
+    PropertyTarget target{i};
 
     for (const auto &property : item.properties.value()) {
         // This function only parses the typed properties.
@@ -171,86 +366,15 @@ void ItemData::loadProperties(const poe::Item &item, ItemData &i)
         }
 
         const poe::ItemPropertyType type = property.type.value();
-        const QString name = property.name;
-        const QString value = std::get<0>(property.values[0]);
-
-        // Only some properties use ok2, so we can default it to true.
-        bool ok = false;
-        bool ok2 = true;
+        const QString &name = property.name;
+        const QString &value = std::get<0>(property.values[0]);
 
-        // clang-format off
-        switch (type) {
-        case poe::ItemPropertyType::Level:                   i.gemLevel = value.section(' ', 0, 0).toInt(&ok); break;
-        case poe::ItemPropertyType::Quality:                 i.quality  = value.sliced(1, value.size() - 2).toInt(&ok); break;
-        case poe::ItemPropertyType::PhysicalDamage:          avg_phys_hit  = average(value, &ok); break;
-        case poe::ItemPropertyType::ElementalDamage:         avg_ele_hit   = average(value, &ok); break;
-        case poe::ItemPropertyType::ChaosDamage:             avg_chaos_hit = average(value, &ok); break;
-        case poe::ItemPropertyType::CriticalStrikeChance:    i.weapon().criticalChance      = value.chopped(1).toFloat(&ok); break;
-        case poe::ItemPropertyType::AttacksPerSecond:        i.weapon().attacksPerSecond    = value.toFloat(&ok); break;
-        case poe::ItemPropertyType::WeaponRange:             i.weapon().weaponRange         = value.toFloat(&ok); break;
-        case poe::ItemPropertyType::ChanceToBlock:           i.armour().block               = value.chopped(1).toInt(&ok); break;
-        case poe::ItemPropertyType::Armour:                  i.armour().armour              = value.toInt(&ok); break;
-        case poe::ItemPropertyType::EvasionRating:           i.armour().evasionRating       = value.toInt(&ok); break;
-        case poe::ItemPropertyType::EnergyShield:            i.armour().energyShield        = value.toInt(&ok); break;
-        case poe::ItemPropertyType::Ward:                    i.armour().ward                = value.toInt(&ok); break;
-        case poe::ItemPropertyType::StackSize:               i.stackSize                    = value.section('/', 0, 0).toInt(&ok);
-                                                             i.stackSizeMax                 = value.section('/', 1, 1).toInt(&ok2); break;
-        case poe::ItemPropertyType::WingsRevealed:           i.heist().wingsRevealed        = value.section('/', 0, 0).toInt(&ok);
-                                                             i.heist().wings                = value.section('/', 1, 1).toInt(&ok2); break;
-        case poe::ItemPropertyType::EscapeRoutesRevealed:    i.heist().escapeRoutesRevealed = value.section('/', 0, 0).toInt(&ok);
-                                                             i.heist().escapeRoutes         = value.section('/', 1, 1).toInt(&ok2); break;
-        case poe::ItemPropertyType::RewardRoomsRevealed:     i.heist().wingsRevealed        = value.section('/', 0, 0).toInt(&ok);
-                                                             i.heist().wings                = value.section('/', 1, 1).toInt(&ok2); break;
-        // Heist requirements can appear in both the item properties and the item requirements.
-        case poe::ItemPropertyType::LockpickingLevel:        i.heist().lockpickingLevel     = value.toInt(&ok); break;
-        case poe::ItemPropertyType::BruteForceLevel:         i.heist().bruteForceLevel      = value.toInt(&ok); break;
-        case poe::ItemPropertyType::PerceptionLevel:         i.heist().perceptionLevel      = value.toInt(&ok); break;
-        case poe::ItemPropertyType::DemolutionLevel:         i.heist().demolutionLevel      = value.toInt(&ok); break;
-        case poe::ItemPropertyType::CounterThaumaturgyLevel: i.heist().counterThaumaturgyLevel = value.toInt(&ok); break;
-        case poe::ItemPropertyType::TrapDisarmamentLevel:    i.heist().trapDisarmamentLevel = value.toInt(&ok); break;
-        case poe::ItemPropertyType::AgilityLevel:            i.heist().agilityLevel         = value.toInt(&ok); break;
-        case poe::ItemPropertyType::DeceptionLevel:          i.heist().deceptionLevel       = value.toInt(&ok); break;
-        case poe::ItemPropertyType::EngineeringLevel:        i.heist().engineeringLevel     = value.toInt(&ok); break;
-        // Silently ignore all these properties:
-        case poe::ItemPropertyType::MapTier:
-        case poe::ItemPropertyType::ItemQuantity:
-        case poe::ItemPropertyType::ItemRarity:
-        case poe::ItemPropertyType::MonsterPackSize:
-        case poe::ItemPropertyType::AreaLevel:
-        case poe::ItemPropertyType::Radius:
-        case poe::ItemPropertyType::HeistTarget:
-        case poe::ItemPropertyType::Limit:
-        case poe::ItemPropertyType::MoreMaps:
-        case poe::ItemPropertyType::MoreScarabs:
-        case poe::ItemPropertyType::BeastiaryGenus:
-        case poe::ItemPropertyType::BeastiaryGroup:
-        case poe::ItemPropertyType::BeastieryFamily:
-        case poe::ItemPropertyType::UltimatumSacrifice:
-        case poe::ItemPropertyType::UltimatumReward:
-        case poe::ItemPropertyType::ValdoMapReward:
-        case poe::ItemPropertyType::ValdoMapConvert:
-        case poe::ItemPropertyType::ValdoShaperReward:   
-        case poe::ItemPropertyType::ValdoElderReward:    
-        case poe::ItemPropertyType::ValdoConquerorReward:
-        case poe::ItemPropertyType::ValdoUniqueReward:    
-        case poe::ItemPropertyType::ValdoScarabReward:
-        case poe::ItemPropertyType::RitualVesselSource:
-            ok = true;
-            break;
-        // These properties should not be present in this part of the item.
-        case poe::ItemPropertyType::RequiredLevel:
-        case poe::ItemPropertyType::RequiredStrength:
-        case poe::ItemPropertyType::RequiredDexterity:
-        case poe::ItemPropertyType::RequiredIntelligence:
-        case poe::ItemPropertyType::RequiredClass:
-        default:
-            spdlog::error("Item a requirement in the properties section");
-            ok = false;
-            break;
+        const PropertyRule *rule = findPropertyRule(type);
+        if (!rule || !(rule->sections & PropertyRule::Properties)) {
+            spdlog::error("Unexpected property in {}: '{}' '{}'", i.prettyName, type, name);
+            continue;
         }
-        // clang-format on
-
-        if (!ok || !ok2) {
+        if (!loadPropertyValue(*rule, value, target)) {
             spdlog::error("Error loading property {} of {}: '{}' from '{}'",
                           type,
                           i.prettyName,
@@ -260,9 +384,11 @@ void ItemData::loadProperties(const poe::Item &item, ItemData &i)
     }
 
     if (i.weaponData) {
-        i.weaponData.value().physicalDps = avg_phys_hit * i.weaponData.value().attacksPerSecond;
-        i.weaponData.value().elementalDps = avg_ele_hit * i.weaponData.value().attacksPerSecond;
-        i.weaponData.value().chaosDps = avg_chaos_hit * i.weaponData.value().attacksPerSecond;
+        WeaponData &weapon = i.weaponData.value();
+        weapon.physicalDps = target.physicalHit * weapon.attacksPerSecond;
+        weapon.elementalDps = target.elementalHit * weapon.attacksPerSecond;
+        weapon.chaosDps = target.chaosHit * weapon.attacksPerSecond;
+        weapon.totalDps = weapon.physicalDps + weapon.elementalDps + weapon.chaosDps;
     }
 }
 
@@ -272,6 +398,8 @@ void ItemData::loadRequirements(const poe::Item &item, ItemData &i)
         return;
     }
 
+    PropertyTarget target{i};
+
     for (const auto &requirement : item.requirements.value()) {
         // We only handle requirements with a type.
         if (!requirement.type) {
@@ -279,54 +407,69 @@ void ItemData::loadRequirements(const poe::Item &item, ItemData &i)
         }
 
         const poe::ItemPropertyType type = requirement.type.value();
-        const QString& name = requirement.name;
-        const QString value = std::get<0>(requirement.values[0]);
-        bool ok = false;
-
-        // Parse the value as an integer because alll but one of the requirement attributes use this.
-        const int k = value.toInt(&ok);
+        const QString &name = requirement.name;
+        const QString &value = std::get<0>(requirement.values[0]);
 
-        // clang-format off
-        switch (type) {
-        case poe::ItemPropertyType::RequiredLevel:           i.requiredLevel                   = k; break;
-        case poe::ItemPropertyType::RequiredStrength:        i.requiredStrength                = k; break;
-        case poe::ItemPropertyType::RequiredDexterity:       i.requiredDexterity               = k; break;
-        case poe::ItemPropertyType::RequiredIntelligence:    i.requiredIntelligence            = k; break;
-        case poe::ItemPropertyType::RequiredClass:           i.requiredClass                   = value; ok = true; break;
-        // Heist requirements can appear in both the item properties and the item requirements.
-        case poe::ItemPropertyType::LockpickingLevel:        i.heist().lockpickingLevel        = k; break;
-        case poe::ItemPropertyType::BruteForceLevel:         i.heist().bruteForceLevel         = k; break;
-        case poe::ItemPropertyType::PerceptionLevel:         i.heist().perceptionLevel         = k; break;
-        case poe::ItemPropertyType::DemolutionLevel:         i.heist().demolutionLevel         = k; break;
-        case poe::ItemPropertyType::CounterThaumaturgyLevel: i.heist().counterThaumaturgyLevel = k; break;
-        case poe::ItemPropertyType::TrapDisarmamentLevel:    i.heist().trapDisarmamentLevel    = k; break;
-        case poe::ItemPropertyType::AgilityLevel:            i.heist().agilityLevel            = k; break;
-        case poe::ItemPropertyType::DeceptionLevel:          i.heist().deceptionLevel          = k; break;
-        case poe::ItemPropertyType::EngineeringLevel:        i.heist().engineeringLevel        = k; break;
-
-        default:
+        const PropertyRule *rule = findPropertyRule(type);
+        if (!rule || !(rule->sections & PropertyRule::Requirements)) {
             spdlog::warn("Unhandled requirement in {}: '{}' '{}'", i.prettyName, type, name);
-            break;
+            continue;
         }
-        // clang-format on
-
-        if (!ok) {
+        if (!loadPropertyValue(*rule, value, target)) {
             spdlog::error("Error loading requirement '{}' from '{}'", name, value);
         }
     }
 }
 
-QStringList ItemData::formatProperties(const poe::Item &item)
+ItemData::DetailData ItemData::detailData(const poe::Item &item)
 {
-    if (!item.properties) {
+    return DetailData{.ilvl = item.ilvl,
+                      .talismanTier = item.talismanTier,
+                      .properties = item.properties,
+                      .requirements = item.requirements,
+                      .implicitMods = item.implicitMods,
+                      .enchantMods = item.enchantMods,
+                      .fracturedMods = item.fracturedMods,
+                      .explicitMods = item.explicitMods,
+                      .craftedMods = item.craftedMods};
+}
+
+ItemData::Details ItemData::details(const DetailData &data)
+{
+    Details details;
+
+    const auto propertySections = ItemData::formatProperties(data);
+    if (propertySections.size() > 0) {
+        details.propertiesText1 = propertySections.front();
+    }
+    if (propertySections.size() > 1) {
+        details.propertiesText2 = propertySections.back();
+    }
+    if (propertySections.size() > 2) {
+        spdlog::error("Encountered a item with {} property sections", propertySections.size());
+    }
+
+    details.requirementsText = ItemData::formatRequirements(data);
+
+    details.implicitMods = ItemData::getMods(data.implicitMods);
+    details.enchantMods = ItemData::getMods(data.enchantMods);
+    details.fracturedMods = ItemData::getMods(data.fracturedMods);
+    details.explicitMods = ItemData::getMods(data.explicitMods);
+    details.craftedMods = ItemData::getMods(data.craftedMods);
+    return details;
+}
+
+QStringList ItemData::formatProperties(const DetailData &data)
+{
+    if (!data.properties) {
         return {};
     }
 
     QStringList sections;
     QStringList lines;
-    lines.reserve(item.properties.value().size());
+    lines.reserve(data.properties.value().size());
 
-    for (const auto &property : item.properties.value()) {
+    for (const auto &property : data.properties.value()) {
         if (property.type == poe::ItemPropertyType::ElementalDamage) {
             // Skip elemental damage since it's already in the explicit mods.
             continue;
@@ -348,23 +491,23 @@ QStringList ItemData::formatProperties(const poe::Item &item)
     return sections;
 }
 
-QString ItemData::formatRequirements(const poe::Item &item)
+QString ItemData::formatRequirements(const DetailData &data)
 {
     QString result;
 
     // The first line is item level.
-    if (item.ilvl > 0) {
+    if (data.ilvl > 0) {
         const poe::ItemProperty property{.name = "Item Level",
-                                         .values = {{QString::number(item.ilvl), 0}},
+                                         .values = {{QString::number(data.ilvl), 0}},
                                          .displayMode = poe::DisplayMode::NameFirst,
                                          .type = poe::ItemPropertyType::Level};
         result = property.render();
     }
 
     // The second line is talisman tier.
-    if (item.talismanTier) {
+    if (data.talismanTier) {
         const poe::ItemProperty property{.name = "Talisman Tier",
-                                         .values = {{QString::number(item.talismanTier.value()), 0}},
+                                         .values = {{QString::number(data.talismanTier.value()), 0}},
                                          .displayMode = poe::DisplayMode::NameFirst,
                                          .type = poe::ItemPropertyType::Level};
         if (!result.isEmpty()) {
@@ -374,12 +517,12 @@ QString ItemData::formatRequirements(const poe::Item &item)
     }
 
     // Attribute requirements are all on the third line.
-    if (item.requirements) {
+    if (data.requirements) {
         if (!result.isEmpty()) {
             result += "<br>";
         }
 
-        const auto &requirements = item.requirements.value();
+        const auto &requirements = data.requirements.value();
         QStringList parts;
         parts.reserve(requirements.size());
         for (const auto &requirement : requirements) {
@@ -394,62 +537,111 @@ QString ItemData::formatRequirements(const poe::Item &item)
     return result;
 }
 
-QStringList ItemData::getMods(const std::optional<std::vector<QString>> mods)
+QStringList ItemData::getMods(const std::optional<std::vector<QString>> &mods)
 {
-    if (mods) {
-        return QStringList(mods.value().begin(), mods.value().end());
-    } else {
+    if (!mods) {
         return {};
     }
+    return QStringList(mods->begin(), mods->end());
 }
 
-float ItemData::average(const QString &ranged_value, bool *ok)
+namespace {
+
+    using Number = std::optional<float>;
+
+    struct Column
+    {
+        enum Type { Text, Int, Float };
+
+        const char *name;
+        Type type;
+        const QString &(*text)(const ItemData &);
+        Number (*number)(const ItemData &);
+    };
+
+    // The columns of the item tree. Every cell is read through this table, so
+    // the getters take the item by reference and only copy the value shown.
+    // Numbers are typed so that the tree can be sorted without QVariant; a
+    // column that does not apply to an item has no number.
+
+    // clang-format off
+    constexpr std::array<Column, ItemData::ColumnCount> COLUMNS = {{
+        // --- Basic fields ---
+        {"Name",           Column::Text,  [](const ItemData &i) -> const QString & { return i.prettyName; }}, // could use i.Name
+        {"Type",           Column::Text,  [](const ItemData &i) -> const QString & { return i.typeLine; }},
+        {"Category",       Column::Text,  [](const ItemData &i) -> const QString & { return i.itemCategory; }},
+        {"Quality",        Column::Int,   nullptr, [](const ItemData &i) -> Number { return i.quality; }},
+        {"Item Level",     Column::Int,   nullptr, [](const ItemData &i) -> Number { return i.itemLevel; }},
+        {"Required Level", Column::Int,   nullptr, [](const ItemData &i) -> Number { return i.requiredLevel; }},
+
+        // --- Weapon fields ---
+        {"Damage",         Column::Float, nullptr, [](const ItemData &i) -> Number { return i.weaponData ? Number(i.weaponData->damage)           : std::nullopt; }},
+        {"Crit Chance",    Column::Float, nullptr, [](const ItemData &i) -> Number { return i.weaponData ? Number(i.weaponData->criticalChance)   : std::nullopt; }},
+        {"Phys DPS",       Column::Float, nullptr, [](const ItemData &i) -> Number { return i.weaponData ? Number(i.weaponData->physicalDps)      : std::nullopt; }},
+        {"Ele DPS",        Column::Float, nullptr, [](const ItemData &i) -> Number { return i.weaponData ? Number(i.weaponData->elementalDps)     : std::nullopt; }},
+        {"Chaos DPS",      Column::Float, nullptr, [](const ItemData &i) -> Number { return i.weaponData ? Number(i.weaponData->chaosDps)         : std::nullopt; }},
+        {"Total DPS",      Column::Float, nullptr, [](const ItemData &i) -> Number { return i.weaponData ? Number(i.weaponData->totalDps)         : std::nullopt; }},
+        {"APS",            Column::Float, nullptr, [](const ItemData &i) -> Number { return i.weaponData ? Number(i.weaponData->attacksPerSecond) : std::nullopt; }},
+        {"Range",          Column::Float, nullptr, [](const ItemData &i) -> Number { return i.weaponData ? Number(i.weaponData->weaponRange)      : std::nullopt; }},
+
+        // --- Armour fields ---
+        {"Armour",         Column::Int,   nullptr, [](const ItemData &i) -> Number { return i.armourData ? Number(i.armourData->armour)         : std::nullopt; }},
+        {"Evasion",        Column::Int,   nullptr, [](const ItemData &i) -> Number { return i.armourData ? Number(i.armourData->evasionRating)  : std::nullopt; }},
+        {"Energy Shield",  Column::Int,   nullptr, [](const ItemData &i) -> Number { return i.armourData ? Number(i.armourData->energyShield)   : std::nullopt; }},
+        {"Block",          Column::Int,   nullptr, [](const ItemData &i) -> Number { return i.armourData ? Number(i.armourData->block)          : std::nullopt; }},
+        {"Ward",           Column::Int,   nullptr, [](const ItemData &i) -> Number { return i.armourData ? Number(i.armourData->ward)           : std::nullopt; }},
+        {"Base",           Column::Int,   nullptr, [](const ItemData &i) -> Number { return i.armourData ? Number(i.armourData->baseBercentile) : std::nullopt; }},
+    }};
+    // clang-format on
+
+    static_assert(std::ranges::all_of(COLUMNS,
+                                      [](const Column &c) {
+                                          return (c.type == Column::Text) ? (c.text != nullptr)
+                                                                          : (c.number != nullptr);
+                                      }),
+                  "Every column needs a getter for its type");
+
+} // namespace
+
+QString ItemData::columnName(int column)
 {
-    const QString left = ranged_value.section('-', 0, 0);
-    const int min = left.toInt(ok);
-    if (*ok) {
-        const QString right = ranged_value.section('-', -1, -1);
-        const float max = right.toFloat(ok);
-        if (*ok) {
-            return (min + max) / 2.0;
-        }
+    if ((column < 0) || (column >= ColumnCount)) {
+        return QString();
     }
-    return 0.0;
-};
+    return QString::fromLatin1(COLUMNS[column].name);
+}
 
-std::vector<ItemData::Column> ItemData::createColumnsInfo()
+QVariant ItemData::columnData(int column) const
 {
-    std::vector<ItemData::Column> columns;
+    if ((column < 0) || (column >= ColumnCount)) {
+        return QVariant();
+    }
+    const Column &c = COLUMNS[column];
+    if (c.type == Column::Text) {
+        return c.text(*this);
+    }
+    const Number number = c.number(*this);
+    if (!number) {
+        return QVariant{""};
+    }
+    return (c.type == Column::Int) ? QVariant{static_cast<int>(*number)} : QVariant{*number};
+}
 
-    // clang-format off
-    
-    // --- Basic fields ---
-    columns.emplace_back("Name",           [](const ItemData &i) -> QVariant { return i.prettyName;    }); // could use i.Name
-    columns.emplace_back("Type",           [](const ItemData &i) -> QVariant { return i.typeLine;      });
-    columns.emplace_back("Category",       [](const ItemData &i) -> QVariant { return i.itemCategory;  });
-    columns.emplace_back("Quality",        [](const ItemData &i) -> QVariant { return i.quality;       });
-    columns.emplace_back("Item Level",     [](const ItemData &i) -> QVariant { return i.itemLevel;     });
-    columns.emplace_back("Required Level", [](const ItemData &i) -> QVariant { return i.requiredLevel; });
-
-    // --- Weapon fields ---
-    columns.emplace_back("Damage",         [](const ItemData &i) -> QVariant { return i.weaponData ? i.weaponData->damage           : QVariant{""}; });
-    columns.emplace_back("Crit Chance",    [](const ItemData &i) -> QVariant { return i.weaponData ? i.weaponData->criticalChance   : QVariant{""}; });
-    columns.emplace_back("Phys DPS",       [](const ItemData &i) -> QVariant { return i.weaponData ? i.weaponData->physicalDps      : QVariant{""}; });
-    columns.emplace_back("Ele DPS",        [](const ItemData &i) -> QVariant { return i.weaponData ? i.weaponData->elementalDps     : QVariant{""}; });
-    columns.emplace_back("Chaos DPS",      [](const ItemData &i) -> QVariant { return i.weaponData ? i.weaponData->chaosDps         : QVariant{""}; });
-    columns.emplace_back("Total DPS",      [](const ItemData &i) -> QVariant { return i.weaponData ? i.weaponData->totalDps         : QVariant{""}; });
-    columns.emplace_back("APS",            [](const ItemData &i) -> QVariant { return i.weaponData ? i.weaponData->attacksPerSecond : QVariant{""}; });
-    columns.emplace_back("Range",          [](const ItemData &i) -> QVariant { return i.weaponData ? i.weaponData->weaponRange      : QVariant{""}; });
-
-    // --- Armour fields ---
-    columns.emplace_back("Armour",         [](const ItemData &i) -> QVariant { return i.armourData ? i.armourData->armour         : QVariant{""}; });
-    columns.emplace_back("Evasion",        [](const ItemData &i) -> QVariant { return i.armourData ? i.armourData->evasionRating  : QVariant{""}; });
-    columns.emplace_back("Energy Shield",  [](const ItemData &i) -> QVariant { return i.armourData ? i.armourData->energyShield   : QVariant{""}; });
-    columns.emplace_back("Block",          [](const ItemData &i) -> QVariant { return i.armourData ? i.armourData->block          : QVariant{""}; });
-    columns.emplace_back("Ward",           [](const ItemData &i) -> QVariant { return i.armourData ? i.armourData->ward           : QVariant{""}; });
-    columns.emplace_back("Base",           [](const ItemData &i) -> QVariant { return i.armourData ? i.armourData->baseBercentile : QVariant{""}; });
+bool ItemData::isTextColumn(int column)
+{
+    return (column >= 0) && (column < ColumnCount) && (COLUMNS[column].type == Column::Text);
+}
 
-    // clang-format on
+const QString &ItemData::columnText(int column) const
+{
+    static const QString empty;
+    return isTextColumn(column) ? COLUMNS[column].text(*this) : empty;
+}
 
-    return columns;
+std::optional<float> ItemData::columnNumber(int column) const
+{
+    if ((column < 0) || (column >= ColumnCount) || isTextColumn(column)) {
+        return std::nullopt;
+    }
+    return COLUMNS[column].number(*this);
 }
@@ -10,10 +10,16 @@
 
 #include <QString>
 #include <QStringList>
+#include <QVariant>
 
+#include <array>
+#include <memory>
 #include <optional>
 #include <vector>
 
+// The tree holds one of these for every item in an account, so the layout is
+// kept small: numbers use the narrowest type that fits their range, flags are
+// single bits, and fields that only a few items have are kept out of line.
 struct ItemData
 {
     struct WeaponData
@@ -30,55 +36,104 @@ struct ItemData
 
     struct ArmourData
     {
-        int armour{0};
-        int energyShield{0};
-        int block{0};
-        int evasionRating{0};
-        int ward{0};
-        int baseBercentile{0};
+        qint32 armour{0};
+        qint32 energyShield{0};
+        qint32 evasionRating{0};
+        qint32 ward{0};
+        qint16 block{0};
+        qint16 baseBercentile{0};
     };
 
     struct SocketGroup
     {
-        unsigned red{0};
-        unsigned green{0};
-        unsigned blue{0};
-        unsigned white{0};
-        unsigned abyss{0};
+        quint8 red{0};
+        quint8 green{0};
+        quint8 blue{0};
+        quint8 white{0};
+        quint8 abyss{0};
     };
 
     struct SocketData
     {
-        std::vector<SocketGroup> socketGroups;
-        unsigned redSockets{0};
-        unsigned greenSockets{0};
-        unsigned blueSockets{0};
-        unsigned whiteSockets{0};
-        unsigned abyssSockets{0}; // custom acquisition extension
-        unsigned totalSockets{0};
+        // An item has at most six sockets, so it has at most six groups.
+        static constexpr size_t MaxGroups = 6;
+
+        std::array<SocketGroup, MaxGroups> socketGroups{};
+        quint8 groupCount{0};
+        quint8 redSockets{0};
+        quint8 greenSockets{0};
+        quint8 blueSockets{0};
+        quint8 whiteSockets{0};
+        quint8 abyssSockets{0}; // custom acquisition extension
+        quint8 totalSockets{0};
     };
 
     struct HeistData
     {
-        int wings{0};
-        int wingsRevealed{0};
-        int escapeRoutes{0};
-        int escapeRoutesRevealed{0};
-        int rewardRooms{0};
-        int rewardRoomsRevealed{0};
-        int lockpickingLevel{0};
-        int bruteForceLevel{0};
-        int perceptionLevel{0};
-        int demolutionLevel{0};
-        int counterThaumaturgyLevel{0};
-        int trapDisarmamentLevel{0};
-        int agilityLevel{0};
-        int deceptionLevel{0};
-        int engineeringLevel{0};
+        qint8 wings{0};
+        qint8 wingsRevealed{0};
+        qint8 escapeRoutes{0};
+        qint8 escapeRoutesRevealed{0};
+        qint8 rewardRooms{0};
+        qint8 rewardRoomsRevealed{0};
+        qint8 lockpickingLevel{0};
+        qint8 bruteForceLevel{0};
+        qint8 perceptionLevel{0};
+        qint8 demolutionLevel{0};
+        qint8 counterThaumaturgyLevel{0};
+        qint8 trapDisarmamentLevel{0};
+        qint8 agilityLevel{0};
+        qint8 deceptionLevel{0};
+        qint8 engineeringLevel{0};
+    };
+
+    // Fields that only a few items have.
+    struct RareData
+    {
+        std::optional<HeistData> heistData;
+        QString requiredClass;
+        QString corpseType;
+        QString alternateArt;
+        QString foilVariation;
+    };
+
+    // Text that is only shown in the tooltip of the selected item. It is
+    // derived from the item when it is needed instead of being kept for
+    // every item in the tree.
+    struct Details
+    {
+        QString propertiesText1;
+        QString propertiesText2;
+        QString requirementsText;
+
+        QStringList implicitMods;
+        QStringList enchantMods;
+        QStringList fracturedMods;
+        QStringList explicitMods;
+        QStringList craftedMods;
+    };
+
+    // The fields of an item that Details are derived from. The tree keeps
+    // these in binary form for each item instead of the whole item, which
+    // would also repeat the socketed items that are nodes of their own.
+    struct DetailData
+    {
+        int ilvl{0};
+        std::optional<int> talismanTier;
+        std::optional<std::vector<poe::ItemProperty>> properties;
+        std::optional<std::vector<poe::ItemProperty>> requirements;
+        std::optional<std::vector<QString>> implicitMods;
+        std::optional<std::vector<QString>> enchantMods;
+        std::optional<std::vector<QString>> fracturedMods;
+        std::optional<std::vector<QString>> explicitMods;
+        std::optional<std::vector<QString>> craftedMods;
     };
 
     ItemData(const poe::Item &item);
 
+    static DetailData detailData(const poe::Item &item);
+    static Details details(const DetailData &data);
+
     QString id;
     QString name;
     QString typeLine;
@@ -87,97 +142,96 @@ struct ItemData
     QString itemCategory;
     QString icon;
 
-    QString propertiesText1;
-    QString propertiesText2;
-    QString requirementsText;
-
-    QStringList implicitMods;
-    QStringList enchantMods;
-    QStringList fracturedMods;
-    QStringList explicitMods;
-    QStringList craftedMods;
-
-    QString requiredClass;
-    QString corpseType;
-    QString alternateArt;
-    QString foilVariation;
+    std::unique_ptr<RareData> rareData;
 
     std::optional<WeaponData> weaponData;
     std::optional<ArmourData> armourData;
     std::optional<SocketData> socketData;
-    std::optional<HeistData> heistData;
 
     poe::FrameType frameType;
 
-    int w{0};
-    int h{0};
+    qint32 gemExperience{0};
+    qint32 storedExperience{0};
+    qint32 stackSize{0};
+    qint32 stackSizeMax{0};
+
+    qint16 w{0};
+    qint16 h{0};
 
-    int requiredLevel{0};
-    int requiredStrength{0};
-    int requiredDexterity{0};
-    int requiredIntelligence{0};
+    qint16 requiredLevel{0};
+    qint16 requiredStrength{0};
+    qint16 requiredDexterity{0};
+    qint16 requiredIntelligence{0};
 
-    int quality{0};
-    int itemLevel{0};
-    int gemLevel{0};
-    int gemExperience{0};
+    qint16 quality{0};
+    qint16 itemLevel{0};
+    qint16 gemLevel{0};
 
-    int talismanTier{0};
-    int storedExperience{0};
-    int stackSize{0};
-    int stackSizeMax{0};
-    int scourgeTier{0};
+    qint8 talismanTier{0};
+    qint8 scourgeTier{0};
 
     // Influences
-    bool shaper{false};
-    bool elder{false};
-    bool crusader{false};
-    bool redeemer{false};
-    bool hunter{false};
-    bool warlord{false};
+    bool shaper : 1 {false};
+    bool elder : 1 {false};
+    bool crusader : 1 {false};
+    bool redeemer : 1 {false};
+    bool hunter : 1 {false};
+    bool warlord : 1 {false};
 
     // Other boolean flags
-    bool transiguredGem{false};
-    bool vaalGem{false};
-    bool crucible{false};
-    bool fractured{false};
-    bool synthesised{false};
-    bool searingExarch{false};
-    bool eaterOfWorlds{false};
-    bool identified{false};
-    bool corrupted{false};
-    bool mirrored{false};
-    bool split{false};
-    bool crafted{false};
-    bool veiled{false};
-    bool forseeing{false};
-
-    struct Column
-    {
-        QString name;
-        std::function<QVariant(const ItemData &)> getter;
-    };
-
-    static const std::vector<Column> Columns;
-    static const int ColumnCount;
+    bool transiguredGem : 1 {false};
+    bool vaalGem : 1 {false};
+    bool crucible : 1 {false};
+    bool fractured : 1 {false};
+    bool synthesised : 1 {false};
+    bool searingExarch : 1 {false};
+    bool eaterOfWorlds : 1 {false};
+    bool identified : 1 {false};
+    bool corrupted : 1 {false};
+    bool mirrored : 1 {false};
+    bool split : 1 {false};
+    bool crafted : 1 {false};
+    bool veiled : 1 {false};
+    bool forseeing : 1 {false};
+
+    // Columns shown in the item tree.
+    static constexpr int ColumnCount = 20;
+    static QString columnName(int column);
+    QVariant columnData(int column) const;
+
+    // Typed column values, so the tree can be sorted without QVariant. A
+    // column is either text or a number, and a number is missing when the
+    // column does not apply to this item.
+    static bool isTextColumn(int column);
+    const QString &columnText(int column) const;
+    std::optional<float> columnNumber(int column) const;
 
 private:
     // These helpers save boilerplate.
     WeaponData &weapon();
     ArmourData &armour();
     SocketData &sockets();
+    RareData &rare();
     HeistData &heist();
 
+    // Describes how to load one type of item property or requirement.
+    struct PropertyRule;
+    struct PropertyTarget;
+
+    static const PropertyRule *findPropertyRule(poe::ItemPropertyType type);
+    static bool loadPropertyValue(const PropertyRule &rule,
+                                  const QString &value,
+                                  PropertyTarget &target);
+
     static void loadSockets(const poe::Item &item, ItemData &i);
     static void loadProperties(const poe::Item &item, ItemData &i);
     static void loadRequirements(const poe::Item &item, ItemData &i);
 
-    static std::vector<Column> createColumnsInfo();
-
-    static QStringList formatProperties(const poe::Item &item);
-    static QString formatRequirements(const poe::Item &item);
-    static QStringList getMods(const std::optional<std::vector<QString>> mods);
-
-    static float average(const QString &ranged_value, bool *ok);
-
+    static QStringList formatProperties(const DetailData &data);
+    static QString formatRequirements(const DetailData &data);
+    static QStringList getMods(const std::optional<std::vector<QString>> &mods);
 };
+
+// This only holds for 64-bit builds, where a QString is 24 bytes.
+static_assert((sizeof(void *) != 8) || (sizeof(ItemData) <= 320),
+              "ItemData has grown; check its layout before raising this limit");
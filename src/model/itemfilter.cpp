@@ -0,0 +1,701 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "model/itemfilter.h"
+
+#include <QStringList>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <latch>
+#include <limits>
+#include <optional>
+#include <utility>
+
+namespace {
+
+    using Number = std::optional<float>;
+
+    // A number is read through the item's column when there is one, so that
+    // the filter and the tree agree on it, or with a getter of its own.
+    struct NumberField
+    {
+        const char *name;
+        const char *column;
+        Number (*get)(const ItemData &);
+    };
+
+    struct TextField
+    {
+        const char *name;
+        const QString &(*get)(const ItemData &);
+    };
+
+    struct FlagField
+    {
+        const char *name;
+        bool (*get)(const ItemData &);
+    };
+
+    struct Rarity
+    {
+        const char *name;
+        poe::FrameType frameType;
+    };
+
+    // The largest number of sockets in one group, ignoring abyss sockets,
+    // which are never linked.
+    Number links(const ItemData &i)
+    {
+        if (!i.socketData) {
+            return std::nullopt;
+        }
+        int links = 0;
+        for (size_t k = 0; k < i.socketData->groupCount; ++k) {
+            const auto &group = i.socketData->socketGroups[k];
+            links = std::max(links, group.red + group.green + group.blue + group.white);
+        }
+        return static_cast<float>(links);
+    }
+
+    // clang-format off
+    constexpr auto NUMBER_FIELDS = std::to_array<NumberField>({
+        // --- Column fields ---
+        {"ilvl",     "Item Level",     nullptr},
+        {"level",    "Required Level", nullptr},
+        {"quality",  "Quality",        nullptr},
+        {"damage",   "Damage",         nullptr},
+        {"crit",     "Crit Chance",    nullptr},
+        {"pdps",     "Phys DPS",       nullptr},
+        {"edps",     "Ele DPS",        nullptr},
+        {"cdps",     "Chaos DPS",      nullptr},
+        {"dps",      "Total DPS",      nullptr},
+        {"aps",      "APS",            nullptr},
+        {"range",    "Range",          nullptr},
+        {"armour",   "Armour",         nullptr},
+        {"evasion",  "Evasion",        nullptr},
+        {"es",       "Energy Shield",  nullptr},
+        {"block",    "Block",          nullptr},
+        {"ward",     "Ward",           nullptr},
+
+        // --- Other fields ---
+        {"str",      nullptr, [](const ItemData &i) -> Number { return i.requiredStrength; }},
+        {"dex",      nullptr, [](const ItemData &i) -> Number { return i.requiredDexterity; }},
+        {"int",      nullptr, [](const ItemData &i) -> Number { return i.requiredIntelligence; }},
+        {"gemlevel", nullptr, [](const ItemData &i) -> Number { return i.gemLevel; }},
+        {"stack",    nullptr, [](const ItemData &i) -> Number { return i.stackSize; }},
+        {"tier",     nullptr, [](const ItemData &i) -> Number { return i.talismanTier; }},
+        {"width",    nullptr, [](const ItemData &i) -> Number { return i.w; }},
+        {"height",   nullptr, [](const ItemData &i) -> Number { return i.h; }},
+
+        // --- Socket fields ---
+        {"sockets",  nullptr, [](const ItemData &i) -> Number { return i.socketData ? Number(i.socketData->totalSockets) : std::nullopt; }},
+        {"links",    nullptr, links},
+        {"red",      nullptr, [](const ItemData &i) -> Number { return i.socketData ? Number(i.socketData->redSockets)   : std::nullopt; }},
+        {"green",    nullptr, [](const ItemData &i) -> Number { return i.socketData ? Number(i.socketData->greenSockets) : std::nullopt; }},
+        {"blue",     nullptr, [](const ItemData &i) -> Number { return i.socketData ? Number(i.socketData->blueSockets)  : std::nullopt; }},
+        {"white",    nullptr, [](const ItemData &i) -> Number { return i.socketData ? Number(i.socketData->whiteSockets) : std::nullopt; }},
+        {"abyss",    nullptr, [](const ItemData &i) -> Number { return i.socketData ? Number(i.socketData->abyssSockets) : std::nullopt; }},
+    });
+
+    constexpr auto TEXT_FIELDS = std::to_array<TextField>({
+        {"name", [](const ItemData &i) -> const QString & { return i.prettyName; }},
+        {"type", [](const ItemData &i) -> const QString & { return i.typeLine; }},
+        {"base", [](const ItemData &i) -> const QString & { return i.baseType; }},
+    });
+
+    constexpr auto FLAG_FIELDS = std::to_array<FlagField>({
+        {"identified",   [](const ItemData &i) { return i.identified; }},
+        {"unidentified", [](const ItemData &i) { return !i.identified; }},
+        {"corrupted",    [](const ItemData &i) { return i.corrupted; }},
+        {"mirrored",     [](const ItemData &i) { return i.mirrored; }},
+        {"split",        [](const ItemData &i) { return i.split; }},
+        {"fractured",    [](const ItemData &i) { return i.fractured; }},
+        {"synthesised",  [](const ItemData &i) { return i.synthesised; }},
+        {"crafted",      [](const ItemData &i) { return i.crafted; }},
+        {"veiled",       [](const ItemData &i) { return i.veiled; }},
+        {"crucible",     [](const ItemData &i) { return i.crucible; }},
+        {"vaal",         [](const ItemData &i) { return i.vaalGem; }},
+        {"transfigured", [](const ItemData &i) { return i.transiguredGem; }},
+        {"shaper",       [](const ItemData &i) { return i.shaper; }},
+        {"elder",        [](const ItemData &i) { return i.elder; }},
+        {"crusader",     [](const ItemData &i) { return i.crusader; }},
+        {"redeemer",     [](const ItemData &i) { return i.redeemer; }},
+        {"hunter",       [](const ItemData &i) { return i.hunter; }},
+        {"warlord",      [](const ItemData &i) { return i.warlord; }},
+        {"exarch",       [](const ItemData &i) { return i.searingExarch; }},
+        {"eater",        [](const ItemData &i) { return i.eaterOfWorlds; }},
+        {"influenced",   [](const ItemData &i) { return i.shaper || i.elder || i.crusader || i.redeemer || i.hunter || i.warlord; }},
+    });
+
+    constexpr auto RARITIES = std::to_array<Rarity>({
+        {"normal",     poe::FrameType::Normal},
+        {"magic",      poe::FrameType::Magic},
+        {"rare",       poe::FrameType::Rare},
+        {"unique",     poe::FrameType::Unique},
+        {"gem",        poe::FrameType::Gem},
+        {"currency",   poe::FrameType::Currency},
+        {"divination", poe::FrameType::DivinationCard},
+        {"quest",      poe::FrameType::Quest},
+    });
+    // clang-format on
+
+    // Returns the position of the entry with the given name, or -1.
+    template<typename Table>
+    int find(const Table &table, const QString &name)
+    {
+        const auto it = std::ranges::find_if(table, [&](const auto &entry) {
+            return name == QLatin1StringView(entry.name);
+        });
+        return (it == table.end()) ? -1 : static_cast<int>(std::distance(table.begin(), it));
+    }
+
+    // The items of a table are split into blocks that threads take in turn.
+    constexpr size_t MATCH_BLOCK_SIZE = 4096;
+
+} // namespace
+
+// An item that is being tested, with its mods decoded the first time that
+// a filter asks for them.
+class ItemFilter::Candidate
+{
+public:
+    Candidate(const NodeTable &nodes, NodeTable::NodeId id)
+        : m_nodes{nodes}
+        , m_id{id}
+        , m_item{*nodes.item(id)}
+    {}
+
+    inline const ItemData &item() const { return m_item; }
+
+    const QStringList &mods()
+    {
+        if (!m_mods) {
+            m_mods = m_nodes.mods(m_id);
+        }
+        return *m_mods;
+    }
+
+private:
+    const NodeTable &m_nodes;
+    const NodeTable::NodeId m_id;
+    const ItemData &m_item;
+    std::optional<QStringList> m_mods;
+};
+
+// Parses a query into a tree of expressions, then generates the program
+// from the tree, with jumps so that "and" and "or" stop as soon as the
+// result is known.
+class ItemFilter::Parser
+{
+public:
+    Parser(const QString &query, ItemFilter &filter)
+        : m_filter{filter}
+    {
+        tokenize(query);
+    }
+
+    bool parse()
+    {
+        if (!m_error.isEmpty()) {
+            return fail(m_error);
+        }
+        if (peek().kind == Token::End) {
+            return true;
+        }
+        Expr expr;
+        if (!parseOr(expr)) {
+            return false;
+        }
+        if (peek().kind != Token::End) {
+            return fail(QString("Unexpected '%1'").arg(peek().text));
+        }
+        generate(expr);
+        if (m_filter.m_program.size() > std::numeric_limits<quint16>::max()) {
+            return fail("The query is too long");
+        }
+        return true;
+    }
+
+private:
+    struct Token
+    {
+        enum Kind { End, Word, String, Compare, Colon, Open, Close, Not } kind;
+        QString text;
+        ItemFilter::Compare compare{ItemFilter::Compare::Equal};
+    };
+
+    struct Expr
+    {
+        enum Kind { Test, Not, And, Or } kind{Test};
+        Instruction test{};
+        std::vector<Expr> children{};
+    };
+
+    void tokenize(const QString &query)
+    {
+        static const QString special = "()\"<>=!:";
+        qsizetype i = 0;
+        while (i < query.size()) {
+            const QChar c = query[i];
+            if (c.isSpace()) {
+                ++i;
+            } else if (c == '(') {
+                m_tokens.push_back({Token::Open, "("});
+                ++i;
+            } else if (c == ')') {
+                m_tokens.push_back({Token::Close, ")"});
+                ++i;
+            } else if (c == ':') {
+                m_tokens.push_back({Token::Colon, ":"});
+                ++i;
+            } else if (c == '"') {
+                const qsizetype end = query.indexOf('"', i + 1);
+                if (end < 0) {
+                    m_error = "A quote is not closed";
+                    return;
+                }
+                m_tokens.push_back({Token::String, query.mid(i + 1, end - i - 1)});
+                i = end + 1;
+            } else if ((c == '<') || (c == '>') || (c == '=') || (c == '!')) {
+                const bool equals = (i + 1 < query.size()) && (query[i + 1] == '=');
+                if ((c == '!') && !equals) {
+                    m_tokens.push_back({Token::Not, "!"});
+                    ++i;
+                    continue;
+                }
+                Token token{Token::Compare, query.mid(i, equals ? 2 : 1)};
+                if (c == '<') {
+                    token.compare = equals ? Compare::LessEqual : Compare::Less;
+                } else if (c == '>') {
+                    token.compare = equals ? Compare::GreaterEqual : Compare::Greater;
+                } else if (c == '!') {
+                    token.compare = Compare::NotEqual;
+                }
+                m_tokens.push_back(token);
+                i += equals ? 2 : 1;
+            } else {
+                const qsizetype start = i;
+                while ((i < query.size()) && !query[i].isSpace() && !special.contains(query[i])) {
+                    ++i;
+                }
+                m_tokens.push_back({Token::Word, query.mid(start, i - start)});
+            }
+        }
+    }
+
+    inline const Token &peek() const
+    {
+        static const Token end{Token::End, "end of query"};
+        return (m_next < m_tokens.size()) ? m_tokens[m_next] : end;
+    }
+
+    inline const Token &next()
+    {
+        const Token &token = peek();
+        m_next = std::min(m_next + 1, m_tokens.size());
+        return token;
+    }
+
+    inline bool peekWord(const char *word) const
+    {
+        const Token &token = peek();
+        return (token.kind == Token::Word) && (token.text.compare(word, Qt::CaseInsensitive) == 0);
+    }
+
+    bool fail(const QString &error)
+    {
+        m_filter.m_error = error;
+        return false;
+    }
+
+    quint16 addText(const QString &text)
+    {
+        m_filter.m_texts.push_back(text);
+        return static_cast<quint16>(m_filter.m_texts.size() - 1);
+    }
+
+    // Mods have to be decoded, so they are tested last.
+    static bool decodes(const Expr &expr)
+    {
+        if (expr.kind == Expr::Test) {
+            return (expr.test.op == Op::Mod) || (expr.test.op == Op::ModCount);
+        }
+        return std::ranges::any_of(expr.children, decodes);
+    }
+
+    // Collects the terms of an "and" or an "or", merging nested ones of the
+    // same kind so that the cheap terms of all of them can go first.
+    static void append(Expr &list, Expr expr)
+    {
+        if (expr.kind == list.kind) {
+            for (auto &child : expr.children) {
+                list.children.push_back(std::move(child));
+            }
+        } else {
+            list.children.push_back(std::move(expr));
+        }
+    }
+
+    static Expr finish(Expr list)
+    {
+        if (list.children.size() == 1) {
+            return std::move(list.children.front());
+        }
+        std::ranges::stable_partition(list.children, [](const Expr &e) { return !decodes(e); });
+        return list;
+    }
+
+    bool parseOr(Expr &out)
+    {
+        Expr list{.kind = Expr::Or};
+        for (;;) {
+            Expr expr;
+            if (!parseAnd(expr)) {
+                return false;
+            }
+            append(list, std::move(expr));
+            if (!peekWord("or")) {
+                break;
+            }
+            next();
+        }
+        out = finish(std::move(list));
+        return true;
+    }
+
+    bool parseAnd(Expr &out)
+    {
+        Expr list{.kind = Expr::And};
+        for (;;) {
+            Expr expr;
+            if (!parseUnary(expr)) {
+                return false;
+            }
+            append(list, std::move(expr));
+            if (peekWord("and")) {
+                next();
+            } else if ((peek().kind == Token::End) || (peek().kind == Token::Close)
+                       || peekWord("or")) {
+                break;
+            }
+        }
+        out = finish(std::move(list));
+        return true;
+    }
+
+    bool parseUnary(Expr &out)
+    {
+        if ((peek().kind == Token::Not) || peekWord("not")) {
+            next();
+            Expr expr;
+            if (!parseUnary(expr)) {
+                return false;
+            }
+            out = Expr{.kind = Expr::Not};
+            out.children.push_back(std::move(expr));
+            return true;
+        }
+        if (peek().kind == Token::Open) {
+            next();
+            if (!parseOr(out)) {
+                return false;
+            }
+            if (next().kind != Token::Close) {
+                return fail("A parenthesis is not closed");
+            }
+            return true;
+        }
+        return parseTerm(out);
+    }
+
+    bool parseTerm(Expr &out)
+    {
+        const Token &token = next();
+        if (token.kind == Token::String) {
+            out.test = {.op = Op::Text, .operand = addText(token.text)};
+            return true;
+        }
+        if (token.kind != Token::Word) {
+            return fail(QString("Unexpected '%1'").arg(token.text));
+        }
+
+        const QString word = token.text.toLower();
+        if (peek().kind == Token::Colon) {
+            next();
+            const Token &value = next();
+            if ((value.kind != Token::Word) && (value.kind != Token::String)) {
+                return fail(QString("Expected text after '%1:'").arg(word));
+            }
+            if (word == "mod") {
+                out.test = {.op = Op::Mod, .operand = addText(value.text)};
+                if (peek().kind == Token::Compare) {
+                    out.test.op = Op::ModCount;
+                    return parseComparison(out.test);
+                }
+                return true;
+            }
+            if (word == "rarity") {
+                const int rarity = find(RARITIES, value.text.toLower());
+                if (rarity < 0) {
+                    return fail(QString("Unknown rarity '%1'").arg(value.text));
+                }
+                out.test = {.op = Op::Rarity, .field = rarityField(rarity)};
+                return true;
+            }
+            const int field = find(TEXT_FIELDS, word);
+            if (field < 0) {
+                return fail(QString("Unknown text field '%1'").arg(word));
+            }
+            out.test = {.op = Op::Text,
+                        .field = static_cast<quint16>(field),
+                        .operand = addText(value.text)};
+            return true;
+        }
+
+        if (peek().kind == Token::Compare) {
+            const int field = find(NUMBER_FIELDS, word);
+            if (field < 0) {
+                return fail(QString("Unknown number field '%1'").arg(word));
+            }
+            if (const char *name = NUMBER_FIELDS[field].column) {
+                const int column = findColumn(name);
+                if (column < 0) {
+                    return fail(QString("The '%1' column is missing").arg(name));
+                }
+                out.test = {.op = Op::Column, .field = static_cast<quint16>(column)};
+            } else {
+                out.test = {.op = Op::Number, .field = static_cast<quint16>(field)};
+            }
+            return parseComparison(out.test);
+        }
+
+        if (const int rarity = find(RARITIES, word); rarity >= 0) {
+            out.test = {.op = Op::Rarity, .field = rarityField(rarity)};
+        } else if (const int flag = find(FLAG_FIELDS, word); flag >= 0) {
+            out.test = {.op = Op::Flag, .field = static_cast<quint16>(flag)};
+        } else {
+            out.test = {.op = Op::Text, .operand = addText(token.text)};
+        }
+        return true;
+    }
+
+    bool parseComparison(Instruction &test)
+    {
+        test.compare = next().compare;
+        const Token &value = next();
+        bool ok = false;
+        test.value = (value.kind == Token::Word) ? value.text.toFloat(&ok) : 0.0f;
+        if (!ok) {
+            return fail(QString("Expected a number instead of '%1'").arg(value.text));
+        }
+        return true;
+    }
+
+    static int findColumn(const char *name)
+    {
+        for (int column = 0; column < ItemData::ColumnCount; ++column) {
+            if (ItemData::columnName(column) == QLatin1StringView(name)) {
+                return column;
+            }
+        }
+        return -1;
+    }
+
+    static quint16 rarityField(int rarity)
+    {
+        return static_cast<quint16>(std::to_underlying(RARITIES[rarity].frameType));
+    }
+
+    void generate(const Expr &expr)
+    {
+        auto &program = m_filter.m_program;
+        switch (expr.kind) {
+        case Expr::Test:
+            program.push_back(expr.test);
+            break;
+        case Expr::Not:
+            generate(expr.children.front());
+            program.push_back({.op = Op::Not});
+            break;
+        case Expr::And:
+        case Expr::Or: {
+            // Each jump goes past the last term once the result is known.
+            const Op jump = (expr.kind == Expr::And) ? Op::JumpIfFalse : Op::JumpIfTrue;
+            std::vector<size_t> jumps;
+            for (size_t i = 0; i < expr.children.size(); ++i) {
+                if (i > 0) {
+                    jumps.push_back(program.size());
+                    program.push_back({.op = jump});
+                }
+                generate(expr.children[i]);
+            }
+            for (const size_t i : jumps) {
+                program[i].operand = static_cast<quint16>(program.size());
+            }
+            break;
+        }
+        }
+    }
+
+    ItemFilter &m_filter;
+    std::vector<Token> m_tokens;
+    size_t m_next{0};
+    QString m_error;
+};
+
+bool ItemFilter::compile(const QString &query)
+{
+    m_program.clear();
+    m_texts.clear();
+    m_error.clear();
+
+    Parser parser(query, *this);
+    if (!parser.parse()) {
+        m_program.clear();
+        m_texts.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ItemFilter::matches(const NodeTable &nodes, NodeTable::NodeId id) const
+{
+    if (!nodes.item(id)) {
+        return false;
+    }
+    Candidate candidate(nodes, id);
+    return run(candidate);
+}
+
+std::vector<std::vector<NodeTable::NodeId>> ItemFilter::matchAll(
+    const std::vector<ItemFilter> &filters,
+    const NodeTable &nodes,
+    QThreadPool &pool,
+    NodeTable::NodeId first)
+{
+    // Each block has its own lists of matches, so the threads never share one.
+    using Matches = std::vector<std::vector<NodeTable::NodeId>>;
+    const size_t count = nodes.size() - std::min<size_t>(first, nodes.size());
+    const size_t blocks = (count + MATCH_BLOCK_SIZE - 1) / MATCH_BLOCK_SIZE;
+    std::vector<Matches> found(blocks, Matches(filters.size()));
+
+    std::atomic<size_t> next{0};
+    const auto work = [&]() {
+        for (size_t block = next++; block < blocks; block = next++) {
+            const size_t begin = first + block * MATCH_BLOCK_SIZE;
+            const size_t end = std::min(begin + MATCH_BLOCK_SIZE, nodes.size());
+            for (auto id = static_cast<NodeTable::NodeId>(begin); id < end; ++id) {
+                if (!nodes.item(id)) {
+                    continue;
+                }
+                Candidate candidate(nodes, id);
+                for (size_t i = 0; i < filters.size(); ++i) {
+                    if (filters[i].run(candidate)) {
+                        found[block][i].push_back(id);
+                    }
+                }
+            }
+        }
+    };
+
+    const auto threads = static_cast<size_t>(std::max(pool.maxThreadCount() - 1, 0));
+    const auto helpers = static_cast<std::ptrdiff_t>(std::min(threads, blocks));
+    std::latch done(helpers);
+    for (std::ptrdiff_t i = 0; i < helpers; ++i) {
+        pool.start([&]() {
+            work();
+            done.count_down();
+        });
+    }
+    work();
+    done.wait();
+
+    Matches matches(filters.size());
+    for (size_t i = 0; i < filters.size(); ++i) {
+        for (const auto &block : found) {
+            matches[i].insert(matches[i].end(), block[i].begin(), block[i].end());
+        }
+    }
+    return matches;
+}
+
+bool ItemFilter::run(Candidate &candidate) const
+{
+    const auto compare = [](float a, Compare op, float b) {
+        switch (op) {
+        case Compare::Less:
+            return a < b;
+        case Compare::LessEqual:
+            return a <= b;
+        case Compare::Equal:
+            return a == b;
+        case Compare::NotEqual:
+            return a != b;
+        case Compare::GreaterEqual:
+            return a >= b;
+        case Compare::Greater:
+            return a > b;
+        }
+        return false;
+    };
+
+    const ItemData &item = candidate.item();
+    bool result = true;
+    size_t pc = 0;
+    while (pc < m_program.size()) {
+        const Instruction &instruction = m_program[pc++];
+        switch (instruction.op) {
+        case Op::Number:
+        case Op::Column: {
+            const Number number = (instruction.op == Op::Column)
+                                      ? item.columnNumber(instruction.field)
+                                      : NUMBER_FIELDS[instruction.field].get(item);
+            result = number && compare(*number, instruction.compare, instruction.value);
+            break;
+        }
+        case Op::Text: {
+            const QString &text = TEXT_FIELDS[instruction.field].get(item);
+            result = text.contains(m_texts[instruction.operand], Qt::CaseInsensitive);
+            break;
+        }
+        case Op::Flag:
+            result = FLAG_FIELDS[instruction.field].get(item);
+            break;
+        case Op::Rarity:
+            result = (std::to_underlying(item.frameType) == instruction.field);
+            break;
+        case Op::Mod:
+        case Op::ModCount: {
+            const QString &text = m_texts[instruction.operand];
+            const auto has_text = [&](const QString &mod) {
+                return mod.contains(text, Qt::CaseInsensitive);
+            };
+            if (instruction.op == Op::Mod) {
+                result = std::ranges::any_of(candidate.mods(), has_text);
+            } else {
+                const auto count = std::ranges::count_if(candidate.mods(), has_text);
+                result = compare(static_cast<float>(count), instruction.compare, instruction.value);
+            }
+            break;
+        }
+        case Op::Not:
+            result = !result;
+            break;
+        case Op::JumpIfFalse:
+            if (!result) {
+                pc = instruction.operand;
+            }
+            break;
+        case Op::JumpIfTrue:
+            if (result) {
+                pc = instruction.operand;
+            }
+            break;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,87 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "model/nodetable.h"
+
+#include <QString>
+
+#include <vector>
+
+class QThreadPool;
+
+// Selects items from the tree with a query such as
+//
+//     rare base:belt ilvl>=84 mod:"maximum life" mod:resistance>=2
+//
+// A query is a list of terms that must all match. Terms can be combined with
+// "and", "or" and "not", and grouped with parentheses. A term is one of:
+//
+//     ilvl>=84           a number compared with <, <=, =, !=, >= or >
+//     base:belt          text that a field contains, ignoring case
+//     mod:life           text that one of the item's mods contains
+//     mod:resist>=2      the number of mods that contain some text
+//     rare, corrupted    a rarity or a flag
+//     "tabula rasa"      text that the name of the item contains
+//
+// A query is compiled once into a short program. Tests that only read
+// ItemData run before tests of mod text, because the tree only keeps mods in
+// binary form and they have to be decoded, so most items are rejected before
+// that happens.
+class ItemFilter
+{
+public:
+    // Compiles a query. An empty query matches every item. If the query is not
+    // valid, this returns false and the filter matches every item.
+    bool compile(const QString &query);
+
+    inline const QString &errorString() const { return m_error; }
+    inline bool isEmpty() const { return m_program.empty(); }
+
+    bool matches(const NodeTable &nodes, NodeTable::NodeId id) const;
+
+    // Runs every filter over the items of a table, starting at the given node,
+    // and returns the ids of the items each one matched, in table order. Each
+    // item is read once for all of the filters, and its mods are decoded at
+    // most once. The items are split between the threads of the pool, and the
+    // calling thread waits for them, so the table must not change meanwhile.
+    static std::vector<std::vector<NodeTable::NodeId>> matchAll(
+        const std::vector<ItemFilter> &filters,
+        const NodeTable &nodes,
+        QThreadPool &pool,
+        NodeTable::NodeId first = NodeTable::Root);
+
+private:
+    enum class Op : quint8 {
+        Number,
+        Column,
+        Text,
+        Flag,
+        Rarity,
+        Mod,
+        ModCount,
+        Not,
+        JumpIfFalse,
+        JumpIfTrue
+    };
+    enum class Compare : quint8 { Less, LessEqual, Equal, NotEqual, GreaterEqual, Greater };
+
+    struct Instruction
+    {
+        Op op;
+        Compare compare{Compare::Equal};
+        quint16 field{0};   // The field, column, flag or rarity that is tested.
+        quint16 operand{0}; // The text in m_texts, or where a jump goes.
+        float value{0.0};
+    };
+
+    class Candidate;
+    class Parser;
+
+    bool run(Candidate &candidate) const;
+
+    std::vector<Instruction> m_program;
+    std::vector<QString> m_texts;
+    QString m_error;
+};
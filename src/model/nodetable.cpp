@@ -0,0 +1,520 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "model/nodetable.h"
+
+#include "util/json.h"
+#include "util/spdlog_qt.h"
+
+static_assert(ACQUISITION_USE_SPDLOG);
+
+#include <QHash>
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+    // Hashes the bytes of a value-only struct such as WeaponData.
+    template<typename T>
+    size_t hashOptional(const std::optional<T> &value, size_t seed)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return value ? qHashBits(&value.value(), sizeof(T), seed) : seed;
+    }
+
+    quint32 itemFlags(const ItemData &i)
+    {
+        const bool flags[] = {i.shaper,        i.elder,      i.crusader,       i.redeemer,
+                              i.hunter,        i.warlord,    i.transiguredGem, i.vaalGem,
+                              i.crucible,      i.fractured,  i.synthesised,    i.searingExarch,
+                              i.eaterOfWorlds, i.identified, i.corrupted,      i.mirrored,
+                              i.split,         i.crafted,    i.veiled,         i.forseeing};
+        quint32 result = 0;
+        for (const bool flag : flags) {
+            result = (result << 1) | (flag ? 1 : 0);
+        }
+        return result;
+    }
+
+    // Hashes what the tree keeps for an item, which is everything it shows or
+    // filters on: the fields of its ItemData and its details in binary form.
+    // Socketed items are nodes of their own, so they are not part of the hash
+    // of the item they are in. New ItemData fields need to be added here.
+    size_t itemHash(const ItemData &i, const QByteArray &details)
+    {
+        size_t seed = qHashMulti(0,
+                                 i.id,
+                                 i.name,
+                                 i.typeLine,
+                                 i.prettyName,
+                                 i.baseType,
+                                 i.itemCategory,
+                                 i.icon,
+                                 details);
+        seed = qHashMulti(seed,
+                          static_cast<int>(i.frameType),
+                          i.gemExperience,
+                          i.storedExperience,
+                          i.stackSize,
+                          i.stackSizeMax,
+                          i.w,
+                          i.h,
+                          i.requiredLevel,
+                          i.requiredStrength,
+                          i.requiredDexterity,
+                          i.requiredIntelligence,
+                          i.quality,
+                          i.itemLevel,
+                          i.gemLevel,
+                          i.talismanTier,
+                          i.scourgeTier,
+                          itemFlags(i));
+        seed = hashOptional(i.weaponData, seed);
+        seed = hashOptional(i.armourData, seed);
+        seed = hashOptional(i.socketData, seed);
+        if (i.rareData) {
+            const auto &rare = *i.rareData;
+            seed = qHashMulti(seed,
+                              rare.requiredClass,
+                              rare.corpseType,
+                              rare.alternateArt,
+                              rare.foilVariation);
+            seed = hashOptional(rare.heistData, seed);
+        }
+        return seed;
+    }
+
+} // namespace
+
+NodeTable::NodeTable()
+{
+    m_folders.push_back("Root");
+    appendNode(Invalid, 0, Kind::Folder, 0);
+    childList(Root);
+}
+
+NodeTable::NodeId NodeTable::addFolder(NodeId folder, const QString &name)
+{
+    const auto payload = static_cast<quint32>(m_folders.size());
+    m_folders.push_back(name);
+    const NodeId id = appendNode(Invalid, 0, Kind::Folder, payload);
+    childList(id);
+    insertChildren(folder, childCount(folder), {id});
+    return id;
+}
+
+NodeTable::NodeId NodeTable::addCharacter(NodeId folder, const poe::Character &character)
+{
+    const auto payload = static_cast<quint32>(m_characters.size());
+    m_characters.emplace_back(character);
+    const NodeId id = appendNode(Invalid, 0, Kind::Character, payload);
+    addCollections(id, character);
+    insertChildren(folder, childCount(folder), {id});
+    return id;
+}
+
+NodeTable::NodeId NodeTable::addStash(NodeId folder, const poe::StashTab &stash)
+{
+    const auto payload = static_cast<quint32>(m_stashes.size());
+    m_stashes.emplace_back(stash);
+    const NodeId id = appendNode(Invalid, 0, Kind::Stash, payload);
+    if (stash.items) {
+        addItems(id, stash.items.value());
+    }
+    insertChildren(folder, childCount(folder), {id});
+    return id;
+}
+
+NodeTable::NodeId NodeTable::adopt(NodeTable &other, NodeId from)
+{
+    const NodeId id = appendNode(Invalid, 0, other.m_kind[from], movePayload(other, from));
+    adoptChildren(other, from, id);
+    return id;
+}
+
+bool NodeTable::replacePayload(NodeId id, NodeTable &other, NodeId from)
+{
+    const quint32 payload = m_payload[id];
+    const quint32 other_payload = other.m_payload[from];
+    switch (m_kind[id]) {
+    case Kind::Folder:
+        return false;
+    case Kind::Character: {
+        const bool renamed = (m_characters[payload].name != other.m_characters[other_payload].name);
+        m_characters[payload] = std::move(other.m_characters[other_payload]);
+        return renamed;
+    }
+    case Kind::Stash: {
+        const bool renamed = (m_stashes[payload].name != other.m_stashes[other_payload].name);
+        m_stashes[payload] = std::move(other.m_stashes[other_payload]);
+        return renamed;
+    }
+    case Kind::Item:
+        if (m_item_hashes[payload] == other.m_item_hashes[other_payload]) {
+            return false;
+        }
+        m_items[payload] = std::move(other.m_items[other_payload]);
+        m_item_hashes[payload] = other.m_item_hashes[other_payload];
+        m_item_details[payload] = std::move(other.m_item_details[other_payload]);
+        return true;
+    case Kind::Removed:
+        break;
+    }
+    return false;
+}
+
+void NodeTable::insertChildren(NodeId parent, int row, const std::vector<NodeId> &children)
+{
+    auto &list = childList(parent);
+    list.insert(list.begin() + row, children.begin(), children.end());
+    for (const NodeId child : children) {
+        m_parent[child] = parent;
+    }
+    m_child_count[parent] = static_cast<quint32>(list.size());
+    renumber(parent, static_cast<size_t>(row));
+}
+
+void NodeTable::removeChildren(NodeId parent, int first, int count)
+{
+    auto &list = childList(parent);
+    const auto begin = list.begin() + first;
+    for (auto it = begin; it != begin + count; ++it) {
+        markRemoved(*it);
+    }
+    list.erase(begin, begin + count);
+    m_child_count[parent] = static_cast<quint32>(list.size());
+    renumber(parent, static_cast<size_t>(first));
+}
+
+std::vector<NodeTable::NodeId> NodeTable::compact()
+{
+    std::vector<NodeId> remap(m_kind.size(), Invalid);
+    NodeId next = 0;
+    for (NodeId id = 0; id < m_kind.size(); ++id) {
+        if (m_kind[id] != Kind::Removed) {
+            remap[id] = next++;
+        }
+    }
+
+    // Live nodes keep their order, so every node only moves towards the
+    // front of the table and blocks of siblings stay next to each other.
+    std::vector<QString> folders;
+    std::vector<CharacterData> characters;
+    std::vector<StashData> stashes;
+    std::vector<ItemData> items;
+    std::vector<size_t> item_hashes;
+    std::vector<QByteArray> item_details;
+    std::vector<std::vector<NodeId>> lists;
+    items.reserve(m_items.size());
+    item_hashes.reserve(m_item_hashes.size());
+    item_details.reserve(m_item_details.size());
+
+    for (NodeId id = 0; id < m_kind.size(); ++id) {
+        const NodeId to = remap[id];
+        if (to == Invalid) {
+            continue;
+        }
+        const NodeId parent = m_parent[id];
+        NodeId first_child = m_first_child[id];
+        if (first_child == Invalid) {
+            // There are no children.
+        } else if (first_child & LIST) {
+            auto &list = m_lists[first_child & ~LIST];
+            for (auto &child : list) {
+                child = remap[child];
+            }
+            first_child = static_cast<NodeId>(lists.size()) | LIST;
+            lists.push_back(std::move(list));
+        } else {
+            first_child = remap[first_child];
+        }
+
+        const quint32 payload = m_payload[id];
+        quint32 new_payload = 0;
+        switch (m_kind[id]) {
+        case Kind::Folder:
+            new_payload = static_cast<quint32>(folders.size());
+            folders.push_back(std::move(m_folders[payload]));
+            break;
+        case Kind::Character:
+            new_payload = static_cast<quint32>(characters.size());
+            characters.push_back(std::move(m_characters[payload]));
+            break;
+        case Kind::Stash:
+            new_payload = static_cast<quint32>(stashes.size());
+            stashes.push_back(std::move(m_stashes[payload]));
+            break;
+        case Kind::Item:
+            new_payload = static_cast<quint32>(items.size());
+            items.push_back(std::move(m_items[payload]));
+            item_hashes.push_back(m_item_hashes[payload]);
+            item_details.push_back(std::move(m_item_details[payload]));
+            break;
+        case Kind::Removed:
+            break;
+        }
+
+        m_parent[to] = (parent == Invalid) ? Invalid : remap[parent];
+        m_row[to] = m_row[id];
+        m_first_child[to] = first_child;
+        m_child_count[to] = m_child_count[id];
+        m_kind[to] = m_kind[id];
+        m_payload[to] = new_payload;
+    }
+
+    m_parent.resize(next);
+    m_row.resize(next);
+    m_first_child.resize(next);
+    m_child_count.resize(next);
+    m_kind.resize(next);
+    m_payload.resize(next);
+
+    m_folders = std::move(folders);
+    m_characters = std::move(characters);
+    m_stashes = std::move(stashes);
+    m_items = std::move(items);
+    m_item_hashes = std::move(item_hashes);
+    m_item_details = std::move(item_details);
+    m_lists = std::move(lists);
+    m_removed = 0;
+    return remap;
+}
+
+std::optional<ItemData::Details> NodeTable::details(NodeId id) const
+{
+    ItemData::DetailData data;
+    if (!decode(id, data)) {
+        return std::nullopt;
+    }
+    return ItemData::details(data);
+}
+
+QStringList NodeTable::mods(NodeId id) const
+{
+    ItemData::DetailData data;
+    if (!decode(id, data)) {
+        return {};
+    }
+    QStringList mods;
+    for (const auto *list : {&data.implicitMods,
+                             &data.enchantMods,
+                             &data.fracturedMods,
+                             &data.explicitMods,
+                             &data.craftedMods}) {
+        if (*list) {
+            mods.append(QStringList((*list)->begin(), (*list)->end()));
+        }
+    }
+    return mods;
+}
+
+bool NodeTable::decode(NodeId id, ItemData::DetailData &data) const
+{
+    if (m_kind[id] != Kind::Item) {
+        return false;
+    }
+    if (!json::parse_binary_into(data, m_item_details[m_payload[id]])) {
+        spdlog::error("NodeTable: unable to decode item {}", m_items[m_payload[id]].id);
+        return false;
+    }
+    return true;
+}
+
+QString NodeTable::key(NodeId id) const
+{
+    const quint32 payload = m_payload[id];
+    switch (m_kind[id]) {
+    case Kind::Folder:
+        return m_folders[payload];
+    case Kind::Character:
+        return m_characters[payload].id;
+    case Kind::Stash:
+        return m_stashes[payload].id;
+    case Kind::Item:
+        return m_items[payload].id;
+    case Kind::Removed:
+        break;
+    }
+    return QString();
+}
+
+QString NodeTable::name(NodeId id) const
+{
+    const quint32 payload = m_payload[id];
+    switch (m_kind[id]) {
+    case Kind::Folder:
+        return m_folders[payload];
+    case Kind::Character:
+        return m_characters[payload].name;
+    case Kind::Stash:
+        return m_stashes[payload].name;
+    case Kind::Item:
+        return m_items[payload].prettyName;
+    case Kind::Removed:
+        break;
+    }
+    return QString();
+}
+
+QVariant NodeTable::data(NodeId id, int column) const
+{
+    if (m_kind[id] == Kind::Item) {
+        return m_items[m_payload[id]].columnData(column);
+    }
+    return (column == 0) ? name(id) : "";
+}
+
+NodeTable::NodeId NodeTable::appendNode(NodeId parent, quint32 row, Kind kind, quint32 payload)
+{
+    const auto id = static_cast<NodeId>(m_kind.size());
+    m_parent.push_back(parent);
+    m_row.push_back(row);
+    m_first_child.push_back(Invalid);
+    m_child_count.push_back(0);
+    m_kind.push_back(kind);
+    m_payload.push_back(payload);
+    return id;
+}
+
+NodeTable::NodeId NodeTable::appendChildren(NodeId parent,
+                                            size_t count,
+                                            Kind kind,
+                                            quint32 first_payload)
+{
+    const auto first = static_cast<NodeId>(m_kind.size());
+    m_first_child[parent] = first;
+    m_child_count[parent] = static_cast<quint32>(count);
+    for (quint32 row = 0; row < count; ++row) {
+        appendNode(parent, row, kind, first_payload + row);
+    }
+    return first;
+}
+
+quint32 NodeTable::movePayload(NodeTable &other, NodeId from)
+{
+    const quint32 payload = other.m_payload[from];
+    switch (other.m_kind[from]) {
+    case Kind::Folder:
+        m_folders.push_back(std::move(other.m_folders[payload]));
+        return static_cast<quint32>(m_folders.size() - 1);
+    case Kind::Character:
+        m_characters.push_back(std::move(other.m_characters[payload]));
+        return static_cast<quint32>(m_characters.size() - 1);
+    case Kind::Stash:
+        m_stashes.push_back(std::move(other.m_stashes[payload]));
+        return static_cast<quint32>(m_stashes.size() - 1);
+    case Kind::Item:
+        m_items.push_back(std::move(other.m_items[payload]));
+        m_item_hashes.push_back(other.m_item_hashes[payload]);
+        m_item_details.push_back(std::move(other.m_item_details[payload]));
+        return static_cast<quint32>(m_items.size() - 1);
+    case Kind::Removed:
+        break;
+    }
+    return 0;
+}
+
+void NodeTable::adoptChildren(NodeTable &other, NodeId from, NodeId to)
+{
+    const int count = other.childCount(from);
+    if (count == 0) {
+        return;
+    }
+
+    // Siblings are copied first so that they stay next to each other.
+    const auto first = static_cast<NodeId>(m_kind.size());
+    m_first_child[to] = first;
+    m_child_count[to] = static_cast<quint32>(count);
+    for (int row = 0; row < count; ++row) {
+        const NodeId child = other.child(from, row);
+        appendNode(to, static_cast<quint32>(row), other.m_kind[child], movePayload(other, child));
+    }
+    for (int row = 0; row < count; ++row) {
+        adoptChildren(other, other.child(from, row), first + static_cast<NodeId>(row));
+    }
+}
+
+void NodeTable::addCollections(NodeId character, const poe::Character &data)
+{
+    // Only collections that contain items get a node.
+    std::vector<std::pair<QString, const std::vector<poe::Item> *>> collections;
+    const auto collect = [&](const char *name, const std::optional<std::vector<poe::Item>> &items) {
+        if (items && !items->empty()) {
+            collections.emplace_back(name, &items.value());
+        }
+    };
+    collect("Equipment", data.equipment);
+    collect("Inventory", data.inventory);
+    collect("Rucksack", data.rucksack);
+    collect("Jewels", data.jewels);
+    if (collections.empty()) {
+        return;
+    }
+
+    const auto first_payload = static_cast<quint32>(m_folders.size());
+    for (const auto &[name, items] : collections) {
+        m_folders.push_back(name);
+    }
+    const NodeId first = appendChildren(character, collections.size(), Kind::Folder, first_payload);
+    for (size_t i = 0; i < collections.size(); ++i) {
+        addItems(first + static_cast<NodeId>(i), *collections[i].second);
+    }
+}
+
+void NodeTable::addItems(NodeId parent, const std::vector<poe::Item> &items)
+{
+    if (items.empty()) {
+        return;
+    }
+
+    // Siblings are added first so that they stay next to each other, and
+    // then the socketed items of each one.
+    const auto first_payload = static_cast<quint32>(m_items.size());
+    for (const auto &item : items) {
+        m_items.emplace_back(item);
+        m_item_details.push_back(json::toBinary(ItemData::detailData(item)));
+        m_item_hashes.push_back(itemHash(m_items.back(), m_item_details.back()));
+    }
+    const NodeId first = appendChildren(parent, items.size(), Kind::Item, first_payload);
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (items[i].socketedItems) {
+            addItems(first + static_cast<NodeId>(i), items[i].socketedItems.value());
+        }
+    }
+}
+
+std::vector<NodeTable::NodeId> &NodeTable::childList(NodeId id)
+{
+    NodeId &first = m_first_child[id];
+    if ((first != Invalid) && (first & LIST)) {
+        return m_lists[first & ~LIST];
+    }
+
+    // Switch from a block of children to a list.
+    std::vector<NodeId> list;
+    list.reserve(m_child_count[id]);
+    for (quint32 row = 0; row < m_child_count[id]; ++row) {
+        list.push_back(first + row);
+    }
+    first = static_cast<NodeId>(m_lists.size()) | LIST;
+    return m_lists.emplace_back(std::move(list));
+}
+
+void NodeTable::renumber(NodeId parent, size_t first_row)
+{
+    const auto &list = childList(parent);
+    for (size_t row = first_row; row < list.size(); ++row) {
+        m_row[list[row]] = static_cast<quint32>(row);
+    }
+}
+
+void NodeTable::markRemoved(NodeId id)
+{
+    for (int row = 0; row < childCount(id); ++row) {
+        markRemoved(child(id, row));
+    }
+    m_kind[id] = Kind::Removed;
+    ++m_removed;
+}
@@ -0,0 +1,138 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "model/characterdata.h"
+#include "model/itemdata.h"
+#include "model/stashdata.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Holds the item tree as a table with one entry per node.
+//
+// Each node property lives in its own array, and the payloads live in one
+// array per kind, so walking the tree reads memory in order instead of
+// following a pointer to every node. Nodes are identified by their position
+// in the table, which is also what TreeModel stores in its indexes.
+//
+// Characters, stashes and items are added together with all of their
+// children, so siblings sit next to each other and a child is found from its
+// parent's first child. A node whose children are later inserted or removed
+// switches to a list of child ids instead, so the ids of the children that
+// stay do not change. Removed nodes stay in the table until it is compacted.
+class NodeTable
+{
+public:
+    using NodeId = quint32;
+
+    enum class Kind : quint8 { Folder, Character, Stash, Item, Removed };
+
+    static constexpr NodeId Root = 0;
+    static constexpr NodeId Invalid = std::numeric_limits<NodeId>::max();
+
+    NodeTable();
+
+    NodeId addFolder(NodeId folder, const QString &name);
+    NodeId addCharacter(NodeId folder, const poe::Character &character);
+    NodeId addStash(NodeId folder, const poe::StashTab &stash);
+
+    // Moves a node and everything below it from another table into this one.
+    // The new node has no parent until it is passed to insertChildren(). This
+    // lets a batch of stashes or characters be built on another thread.
+    NodeId adopt(NodeTable &other, NodeId from);
+
+    // Replaces the payload of a node with the payload of a node from another
+    // table, leaving the children alone. Returns true if the node would now be
+    // displayed differently. Items that have not changed are left in place.
+    bool replacePayload(NodeId id, NodeTable &other, NodeId from);
+
+    void insertChildren(NodeId parent, int row, const std::vector<NodeId> &children);
+
+    // Removes count children starting at first, along with everything below
+    // them, and renumbers the children after them.
+    void removeChildren(NodeId parent, int first, int count);
+
+    // Removed nodes are reclaimed once they make up half of the table.
+    inline bool needsCompaction() const { return m_removed > (m_kind.size() / 2); }
+
+    // Drops removed nodes and returns the new id of every old one, or Invalid
+    // for the nodes that were dropped. Rows do not change.
+    std::vector<NodeId> compact();
+
+    inline size_t size() const { return m_kind.size(); }
+    inline Kind kind(NodeId id) const { return m_kind[id]; }
+    inline NodeId parent(NodeId id) const { return m_parent[id]; }
+    inline int row(NodeId id) const { return static_cast<int>(m_row[id]); }
+    inline int childCount(NodeId id) const { return static_cast<int>(m_child_count[id]); }
+
+    inline NodeId child(NodeId id, int row) const
+    {
+        if ((row < 0) || (row >= childCount(id))) {
+            return Invalid;
+        }
+        const NodeId first = m_first_child[id];
+        return (first & LIST) ? m_lists[first & ~LIST][row] : first + row;
+    }
+
+    inline const ItemData *item(NodeId id) const
+    {
+        return (m_kind[id] == Kind::Item) ? &m_items[m_payload[id]] : nullptr;
+    }
+
+    // Derives the tooltip text of an item from its encoded detail fields.
+    std::optional<ItemData::Details> details(NodeId id) const;
+
+    // Decodes every mod of an item from its encoded detail fields, in tooltip order.
+    QStringList mods(NodeId id) const;
+
+    // Identifies a node among its siblings across refreshes: the id of a
+    // character, stash or item, or the name of a folder.
+    QString key(NodeId id) const;
+
+    QString name(NodeId id) const;
+    QVariant data(NodeId id, int column) const;
+
+private:
+    // Marks a first child that is actually an index into m_lists.
+    static constexpr NodeId LIST = NodeId{1} << 31;
+
+    NodeId appendNode(NodeId parent, quint32 row, Kind kind, quint32 payload);
+    NodeId appendChildren(NodeId parent, size_t count, Kind kind, quint32 first_payload);
+    quint32 movePayload(NodeTable &other, NodeId from);
+    bool decode(NodeId id, ItemData::DetailData &data) const;
+    void adoptChildren(NodeTable &other, NodeId from, NodeId to);
+
+    void addCollections(NodeId character, const poe::Character &data);
+    void addItems(NodeId parent, const std::vector<poe::Item> &items);
+
+    std::vector<NodeId> &childList(NodeId id);
+    void renumber(NodeId parent, size_t first_row);
+    void markRemoved(NodeId id);
+
+    // Node properties, indexed by NodeId.
+    std::vector<NodeId> m_parent;
+    std::vector<quint32> m_row;
+    std::vector<NodeId> m_first_child; // Or an index into m_lists, marked with LIST.
+    std::vector<quint32> m_child_count;
+    std::vector<Kind> m_kind;
+    std::vector<quint32> m_payload; // Index into the payload array for the kind.
+
+    // Payloads, indexed by m_payload.
+    std::vector<QString> m_folders;
+    std::vector<CharacterData> m_characters;
+    std::vector<StashData> m_stashes;
+    std::vector<ItemData> m_items;
+    std::vector<size_t> m_item_hashes;      // Used to tell whether an item changed.
+    std::vector<QByteArray> m_item_details; // The detail fields of each item in binary form.
+
+    std::vector<std::vector<NodeId>> m_lists;
+    size_t m_removed{0};
+};
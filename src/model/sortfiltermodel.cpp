@@ -0,0 +1,472 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "model/sortfiltermodel.h"
+
+#include "model/treemodel.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+    constexpr quint32 MISSING_KEY = std::numeric_limits<quint32>::max();
+
+    // Maps a number onto an unsigned integer with the same order, so that the
+    // keys of a sort compare as plain integers. Items without the number are
+    // sorted last in either order.
+    quint32 numberKey(std::optional<float> number, Qt::SortOrder order)
+    {
+        if (!number) {
+            return MISSING_KEY;
+        }
+        const auto bits = std::bit_cast<quint32>(*number);
+        const quint32 key = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        return std::min((order == Qt::AscendingOrder) ? key : ~key, MISSING_KEY - 1);
+    }
+
+    void sortUnique(std::vector<NodeTable::NodeId> &ids)
+    {
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+
+} // namespace
+
+SortFilterModel::SortFilterModel(TreeModel &source, QObject *parent)
+    : QAbstractItemModel{parent}
+    , m_source{source}
+{
+    m_applyTimer.setSingleShot(true);
+    m_applyTimer.setInterval(0);
+    connect(&m_applyTimer, &QTimer::timeout, this, &SortFilterModel::applyChanges);
+
+    connect(&m_source, &QAbstractItemModel::rowsInserted, this, &SortFilterModel::markDirty);
+    connect(&m_source, &QAbstractItemModel::rowsRemoved, this, &SortFilterModel::markDirty);
+    connect(&m_source, &QAbstractItemModel::dataChanged, this, &SortFilterModel::markChanged);
+    connect(&m_source,
+            &QAbstractItemModel::layoutAboutToBeChanged,
+            this,
+            &SortFilterModel::sourceLayoutAboutToBeChanged);
+    connect(&m_source,
+            &QAbstractItemModel::layoutChanged,
+            this,
+            &SortFilterModel::sourceLayoutChanged);
+    connect(&m_source, &QAbstractItemModel::modelAboutToBeReset, this, [this]() {
+        beginResetModel();
+    });
+    connect(&m_source, &QAbstractItemModel::modelReset, this, [this]() {
+        rebuild();
+        endResetModel();
+    });
+
+    rebuild();
+}
+
+QModelIndex SortFilterModel::index(int row, int column, const QModelIndex &parent) const
+{
+    const NodeTable::NodeId id = getNode(parent);
+    if (!isMapped(id) || (row < 0) || (static_cast<size_t>(row) >= m_children[id].size())) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, static_cast<quintptr>(m_children[id][row]));
+}
+
+QModelIndex SortFilterModel::parent(const QModelIndex &index) const
+{
+    const NodeTable::NodeId id = getNode(index);
+    if (id == NodeTable::Root) {
+        return QModelIndex();
+    }
+    return indexOf(m_source.nodes().parent(id));
+}
+
+QVariant SortFilterModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole)) {
+        return QVariant();
+    }
+    return m_source.nodes().data(getNode(index), index.column());
+}
+
+QVariant SortFilterModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    return m_source.headerData(section, orientation, role);
+}
+
+void SortFilterModel::sort(int column, Qt::SortOrder order)
+{
+    applyChanges();
+    m_sortColumn = (column < ItemData::ColumnCount) ? column : -1;
+    m_sortOrder = order;
+
+    // Sorting does not change which items are shown, only their rows.
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    for (NodeTable::NodeId id = 0; id < m_rows.size(); ++id) {
+        if (isMapped(id) && holdsItems(id)) {
+            m_children[id] = arrange(id);
+            renumber(id, 0);
+        }
+    }
+    updatePersistentRows();
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void SortFilterModel::setFilter(ItemFilter filter)
+{
+    applyChanges();
+    m_filter = std::move(filter);
+    matchItems(NodeTable::Root);
+
+    // Only items are filtered, so the nodes that hold them stay mapped.
+    std::vector<NodeTable::NodeId> parents;
+    for (NodeTable::NodeId id = 0; id < m_rows.size(); ++id) {
+        if (isMapped(id) && holdsItems(id)) {
+            parents.push_back(id);
+        }
+    }
+    for (const NodeTable::NodeId parent : parents) {
+        sync(parent);
+    }
+}
+
+QModelIndex SortFilterModel::mapToSource(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return QModelIndex();
+    }
+    return m_source.indexOf(getNode(index)).siblingAtColumn(index.column());
+}
+
+const ItemData *SortFilterModel::getItem(const QModelIndex &index) const
+{
+    const NodeTable::NodeId id = getNode(index);
+    return isMapped(id) ? m_source.nodes().item(id) : nullptr;
+}
+
+ItemData::Details SortFilterModel::getDetails(const QModelIndex &index) const
+{
+    return m_source.getDetails(mapToSource(index));
+}
+
+QModelIndex SortFilterModel::indexOf(NodeTable::NodeId id) const
+{
+    if ((id == NodeTable::Root) || !isMapped(id)) {
+        return QModelIndex();
+    }
+    return createIndex(static_cast<int>(m_rows[id]), 0, static_cast<quintptr>(id));
+}
+
+// Stashes and the collections of a character hold items, which are the only
+// rows that are sorted and filtered.
+bool SortFilterModel::holdsItems(NodeTable::NodeId parent) const
+{
+    const NodeTable &nodes = m_source.nodes();
+    if ((nodes.kind(parent) == NodeTable::Kind::Item) || (nodes.childCount(parent) == 0)) {
+        return false;
+    }
+    return nodes.kind(nodes.child(parent, 0)) == NodeTable::Kind::Item;
+}
+
+// Returns the children of a node that should be shown, in the order they
+// should be shown in.
+std::vector<NodeTable::NodeId> SortFilterModel::arrange(NodeTable::NodeId parent) const
+{
+    const NodeTable &nodes = m_source.nodes();
+    const int count = nodes.childCount(parent);
+    const bool items = holdsItems(parent);
+
+    std::vector<NodeTable::NodeId> children;
+    children.reserve(static_cast<size_t>(count));
+    for (int row = 0; row < count; ++row) {
+        const NodeTable::NodeId child = nodes.child(parent, row);
+        if (items && nodes.item(child) && !isMatch(child)) {
+            continue;
+        }
+        children.push_back(child);
+    }
+    if (items && (m_sortColumn >= 0)) {
+        sortItems(children);
+    }
+    return children;
+}
+
+// Reads the key of every item once, and then sorts by the keys alone. The
+// sort is stable, so items with the same key keep the order of the tree.
+void SortFilterModel::sortItems(std::vector<NodeTable::NodeId> &items) const
+{
+    const NodeTable &nodes = m_source.nodes();
+
+    if (ItemData::isTextColumn(m_sortColumn)) {
+        std::vector<std::pair<QString, NodeTable::NodeId>> keys;
+        keys.reserve(items.size());
+        for (const NodeTable::NodeId id : items) {
+            const ItemData *item = nodes.item(id);
+            keys.emplace_back(item ? item->columnText(m_sortColumn) : nodes.name(id), id);
+        }
+        const bool ascending = (m_sortOrder == Qt::AscendingOrder);
+        std::stable_sort(keys.begin(), keys.end(), [ascending](const auto &a, const auto &b) {
+            const int result = QString::compare(a.first, b.first, Qt::CaseInsensitive);
+            return ascending ? (result < 0) : (result > 0);
+        });
+        std::ranges::transform(keys, items.begin(), [](const auto &key) { return key.second; });
+        return;
+    }
+
+    std::vector<std::pair<quint32, NodeTable::NodeId>> keys;
+    keys.reserve(items.size());
+    for (const NodeTable::NodeId id : items) {
+        const ItemData *item = nodes.item(id);
+        const auto number = item ? item->columnNumber(m_sortColumn) : std::nullopt;
+        keys.emplace_back(numberKey(number, m_sortOrder), id);
+    }
+    std::stable_sort(keys.begin(), keys.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+    std::ranges::transform(keys, items.begin(), [](const auto &key) { return key.second; });
+}
+
+// Runs the filter over the nodes from first on. The tree is only changed on
+// this thread, which waits for the pool, so it stays put while it is read.
+void SortFilterModel::matchItems(NodeTable::NodeId first)
+{
+    if (m_filter.isEmpty()) {
+        m_matches.clear();
+        return;
+    }
+    const NodeTable &nodes = m_source.nodes();
+    m_matches.resize(nodes.size(), false);
+    std::fill(m_matches.begin() + std::min<size_t>(first, nodes.size()), m_matches.end(), false);
+    const auto matches = ItemFilter::matchAll({m_filter}, nodes, m_filterPool, first);
+    for (const NodeTable::NodeId id : matches.front()) {
+        m_matches[id] = true;
+    }
+}
+
+// Maps the children of a node and everything below them. The row of the node
+// itself is set when it is inserted into its parent.
+void SortFilterModel::build(NodeTable::NodeId id)
+{
+    m_children[id] = arrange(id);
+    renumber(id, 0);
+    for (const NodeTable::NodeId child : m_children[id]) {
+        build(child);
+    }
+}
+
+void SortFilterModel::rebuild()
+{
+    const size_t size = m_source.nodes().size();
+    m_rows.assign(size, Unmapped);
+    m_children.assign(size, {});
+    m_dirtyParents.clear();
+    m_changedNodes.clear();
+    m_applyTimer.stop();
+    matchItems(NodeTable::Root);
+
+    m_rows[NodeTable::Root] = 0;
+    build(NodeTable::Root);
+}
+
+void SortFilterModel::unmap(NodeTable::NodeId id)
+{
+    m_rows[id] = Unmapped;
+    for (const NodeTable::NodeId child : m_children[id]) {
+        unmap(child);
+    }
+    m_children[id] = {};
+}
+
+void SortFilterModel::renumber(NodeTable::NodeId parent, size_t first_row)
+{
+    const auto &children = m_children[parent];
+    for (size_t row = first_row; row < children.size(); ++row) {
+        m_rows[children[row]] = static_cast<quint32>(row);
+    }
+}
+
+// Brings the rows under a node in line with the tree, with the smallest
+// ranges of removed and inserted rows that views can follow.
+void SortFilterModel::sync(NodeTable::NodeId parent)
+{
+    const std::vector<NodeTable::NodeId> wanted = arrange(parent);
+    std::vector<NodeTable::NodeId> wanted_ids = wanted;
+    std::sort(wanted_ids.begin(), wanted_ids.end());
+    const auto is_wanted = [&wanted_ids](NodeTable::NodeId id) {
+        return std::binary_search(wanted_ids.begin(), wanted_ids.end(), id);
+    };
+
+    auto &children = m_children[parent];
+    const QModelIndex index = indexOf(parent);
+
+    // Rows that are gone or filtered out are removed from the end, so that
+    // the rows before them stay put.
+    for (int last = static_cast<int>(children.size()) - 1; last >= 0; --last) {
+        if (is_wanted(children[last])) {
+            continue;
+        }
+        int first = last;
+        while ((first > 0) && !is_wanted(children[first - 1])) {
+            --first;
+        }
+        beginRemoveRows(index, first, last);
+        for (int row = first; row <= last; ++row) {
+            unmap(children[row]);
+        }
+        children.erase(children.begin() + first, children.begin() + last + 1);
+        renumber(parent, static_cast<size_t>(first));
+        endRemoveRows();
+        last = first;
+    }
+
+    // The rows that stay are moved into their new order.
+    std::vector<NodeTable::NodeId> kept;
+    kept.reserve(children.size());
+    std::ranges::copy_if(wanted, std::back_inserter(kept), [this](NodeTable::NodeId id) {
+        return isMapped(id);
+    });
+    if (kept != children) {
+        QList<QPersistentModelIndex> parents;
+        if (parent != NodeTable::Root) {
+            parents.append(index);
+        }
+        emit layoutAboutToBeChanged(parents, QAbstractItemModel::VerticalSortHint);
+        children = std::move(kept);
+        renumber(parent, 0);
+        updatePersistentRows();
+        emit layoutChanged(parents, QAbstractItemModel::VerticalSortHint);
+    }
+
+    // New rows are inserted between them.
+    size_t row = 0;
+    while (row < wanted.size()) {
+        if (isMapped(wanted[row])) {
+            ++row;
+            continue;
+        }
+        const size_t first = row;
+        while ((row < wanted.size()) && !isMapped(wanted[row])) {
+            build(wanted[row]);
+            ++row;
+        }
+        beginInsertRows(index, static_cast<int>(first), static_cast<int>(row) - 1);
+        children.insert(children.begin() + first, wanted.begin() + first, wanted.begin() + row);
+        renumber(parent, first);
+        endInsertRows();
+    }
+}
+
+void SortFilterModel::updatePersistentRows()
+{
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &index : from) {
+        const NodeTable::NodeId id = getNode(index);
+        if (isMapped(id)) {
+            const int row = static_cast<int>(m_rows[id]);
+            to.append(createIndex(row, index.column(), index.internalId()));
+        } else {
+            to.append(QModelIndex());
+        }
+    }
+    changePersistentIndexList(from, to);
+}
+
+void SortFilterModel::markDirty(const QModelIndex &source_parent)
+{
+    m_dirtyParents.push_back(m_source.getNode(source_parent));
+    m_applyTimer.start();
+}
+
+void SortFilterModel::markChanged(const QModelIndex &top_left, const QModelIndex &bottom_right)
+{
+    for (int row = top_left.row(); row <= bottom_right.row(); ++row) {
+        m_changedNodes.push_back(m_source.getNode(top_left.siblingAtRow(row)));
+    }
+
+    // A changed item may have a new key or no longer match the filter.
+    markDirty(top_left.parent());
+}
+
+void SortFilterModel::applyChanges()
+{
+    m_applyTimer.stop();
+    if (m_dirtyParents.empty() && m_changedNodes.empty()) {
+        return;
+    }
+
+    const NodeTable &nodes = m_source.nodes();
+    m_rows.resize(nodes.size(), Unmapped);
+    m_children.resize(nodes.size());
+
+    // New items are matched together, and changed ones one at a time.
+    sortUnique(m_changedNodes);
+    if (!m_filter.isEmpty()) {
+        matchItems(static_cast<NodeTable::NodeId>(m_matches.size()));
+        for (const NodeTable::NodeId id : m_changedNodes) {
+            if (nodes.item(id)) {
+                m_matches[id] = m_filter.matches(nodes, id);
+            }
+        }
+    }
+
+    // Parents that are not shown, or that were removed, are skipped. Their
+    // own parents are synced too, which maps or unmaps them as a whole.
+    sortUnique(m_dirtyParents);
+    for (const NodeTable::NodeId parent : m_dirtyParents) {
+        if (isMapped(parent) && (nodes.kind(parent) != NodeTable::Kind::Removed)) {
+            sync(parent);
+        }
+    }
+    m_dirtyParents.clear();
+
+    for (const NodeTable::NodeId id : m_changedNodes) {
+        if (isMapped(id) && (nodes.kind(id) != NodeTable::Kind::Removed)) {
+            const int row = static_cast<int>(m_rows[id]);
+            const QModelIndex first = createIndex(row, 0, static_cast<quintptr>(id));
+            emit dataChanged(first, first.siblingAtColumn(ItemData::ColumnCount - 1));
+        }
+    }
+    m_changedNodes.clear();
+}
+
+// The source compacts its table with a layout change, which gives the nodes
+// new ids. The persistent indexes are carried over through the source's own.
+void SortFilterModel::sourceLayoutAboutToBeChanged()
+{
+    applyChanges();
+    emit layoutAboutToBeChanged();
+
+    m_layoutIndexes = persistentIndexList();
+    m_layoutSourceIndexes.clear();
+    m_layoutSourceIndexes.reserve(m_layoutIndexes.size());
+    for (const QModelIndex &index : std::as_const(m_layoutIndexes)) {
+        m_layoutSourceIndexes.append(m_source.indexOf(getNode(index)));
+    }
+}
+
+void SortFilterModel::sourceLayoutChanged()
+{
+    rebuild();
+
+    QModelIndexList to;
+    to.reserve(m_layoutIndexes.size());
+    for (qsizetype i = 0; i < m_layoutIndexes.size(); ++i) {
+        const QPersistentModelIndex &source = m_layoutSourceIndexes[i];
+        const NodeTable::NodeId id = m_source.getNode(source);
+        if (source.isValid() && isMapped(id)) {
+            const int row = static_cast<int>(m_rows[id]);
+            to.append(createIndex(row, m_layoutIndexes[i].column(), static_cast<quintptr>(id)));
+        } else {
+            to.append(QModelIndex());
+        }
+    }
+    changePersistentIndexList(m_layoutIndexes, to);
+    m_layoutIndexes.clear();
+    m_layoutSourceIndexes.clear();
+
+    emit layoutChanged();
+}
@@ -0,0 +1,153 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "model/itemdata.h"
+#include "model/itemfilter.h"
+#include "model/nodetable.h"
+
+#include <QAbstractItemModel>
+#include <QList>
+#include <QPersistentModelIndex>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <limits>
+#include <vector>
+
+class TreeModel;
+
+// Sorts and filters the items of a TreeModel for the item view.
+//
+// Items are sorted and filtered among the other items of the same stash or
+// character inventory. Folders, stashes, characters and socketed items keep
+// the order they have in the tree. Each sort reads one typed key per item
+// from ItemData instead of comparing QVariants. A filter is run over all of
+// the items at once on a thread pool, and only the items that are added or
+// changed afterwards are tested one at a time.
+//
+// Rows are mapped by the ids of their nodes, which do not change when the tree
+// is updated. Changes to the tree are collected and applied once control
+// returns to the event loop, so a refreshed stash is sorted once instead of
+// once for every item in it that changed.
+class SortFilterModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    explicit SortFilterModel(TreeModel &source, QObject *parent = nullptr);
+
+    inline Qt::ItemFlags flags(const QModelIndex &index) const override
+    {
+        return index.isValid() ? (Qt::ItemIsEnabled | Qt::ItemIsSelectable) : Qt::NoItemFlags;
+    }
+
+    QModelIndex index(int row,
+                      int column,
+                      const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &index) const override;
+
+    inline int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        const NodeTable::NodeId id = getNode(parent);
+        return isMapped(id) ? static_cast<int>(m_children[id].size()) : 0;
+    }
+
+    inline int columnCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return ItemData::ColumnCount;
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    inline bool hasChildren(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return rowCount(parent) > 0;
+    }
+
+    QVariant headerData(int section,
+                        Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    // Sorts the items by a column, or restores the order of the tree when the
+    // column is negative.
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // Hides the items that the filter rejects. An empty filter shows them all.
+    void setFilter(ItemFilter filter);
+
+    QModelIndex mapToSource(const QModelIndex &index) const;
+
+    // Returns the item at the given index, or nullptr if it is not an item.
+    const ItemData *getItem(const QModelIndex &index) const;
+    ItemData::Details getDetails(const QModelIndex &index) const;
+
+private:
+    // Marks the nodes that are not shown in m_rows.
+    static constexpr quint32 Unmapped = std::numeric_limits<quint32>::max();
+
+    inline NodeTable::NodeId getNode(const QModelIndex &index) const
+    {
+        return index.isValid() ? static_cast<NodeTable::NodeId>(index.internalId())
+                               : NodeTable::Root;
+    }
+
+    inline bool isMapped(NodeTable::NodeId id) const
+    {
+        return (id < m_rows.size()) && (m_rows[id] != Unmapped);
+    }
+
+    inline bool isMatch(NodeTable::NodeId id) const
+    {
+        return m_filter.isEmpty() || ((id < m_matches.size()) && m_matches[id]);
+    }
+
+    QModelIndex indexOf(NodeTable::NodeId id) const;
+
+    bool holdsItems(NodeTable::NodeId parent) const;
+    std::vector<NodeTable::NodeId> arrange(NodeTable::NodeId parent) const;
+    void sortItems(std::vector<NodeTable::NodeId> &items) const;
+
+    void matchItems(NodeTable::NodeId first);
+    void build(NodeTable::NodeId id);
+    void rebuild();
+    void unmap(NodeTable::NodeId id);
+    void renumber(NodeTable::NodeId parent, size_t first_row);
+    void sync(NodeTable::NodeId parent);
+    void updatePersistentRows();
+
+    void markDirty(const QModelIndex &source_parent);
+    void markChanged(const QModelIndex &top_left, const QModelIndex &bottom_right);
+    void applyChanges();
+
+    void sourceLayoutAboutToBeChanged();
+    void sourceLayoutChanged();
+
+    TreeModel &m_source;
+
+    int m_sortColumn{-1};
+    Qt::SortOrder m_sortOrder{Qt::AscendingOrder};
+    ItemFilter m_filter;
+
+    // Whether each node matched the filter, indexed by the ids of the source
+    // nodes. It is empty when there is no filter.
+    std::vector<bool> m_matches;
+
+    // The row of every node that is shown, and the children it shows, in
+    // order. Both are indexed by the ids of the source nodes.
+    std::vector<quint32> m_rows;
+    std::vector<std::vector<NodeTable::NodeId>> m_children;
+
+    // Changes that have not been applied yet.
+    std::vector<NodeTable::NodeId> m_dirtyParents;
+    std::vector<NodeTable::NodeId> m_changedNodes;
+    QTimer m_applyTimer;
+
+    // Persistent indexes that are carried across a layout change of the
+    // source, which gives every node a new id.
+    QModelIndexList m_layoutIndexes;
+    QList<QPersistentModelIndex> m_layoutSourceIndexes;
+
+    QThreadPool m_filterPool;
+};
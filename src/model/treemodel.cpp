@@ -2,35 +2,116 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include "model/treemodel.h"
-#include "model/treenode.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <latch>
+#include <limits>
+#include <utility>
+
+// How long single stashes and characters are held before a batch is built.
+constexpr int BATCH_DELAY_MSECS = 50;
+
+// How many items keep their tooltip text once it has been derived.
+constexpr int DETAILS_CACHE_SIZE = 256;
+
+// Stashes without an index are sorted last.
+constexpr unsigned UNKNOWN_INDEX = std::numeric_limits<unsigned>::max();
+
+namespace {
+
+    // Only the last copy of a stash or character that arrived more than once
+    // in the same batch is kept.
+    template<typename T>
+    void keepLatest(std::vector<T> &list)
+    {
+        QHash<QString, size_t> latest;
+        for (size_t i = 0; i < list.size(); ++i) {
+            latest.insert(list[i].id, i);
+        }
+        if (static_cast<size_t>(latest.size()) == list.size()) {
+            return;
+        }
+        std::vector<T> unique;
+        unique.reserve(static_cast<size_t>(latest.size()));
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (latest.value(list[i].id) == i) {
+                unique.push_back(std::move(list[i]));
+            }
+        }
+        list = std::move(unique);
+    }
+
+    // Builds one subtree for each stash or character, spread over the threads
+    // of the pool, and then moves them into a single table in the same order.
+    // The list is released before the table is returned, so the stashes and
+    // characters are not held in memory next to the tree any longer than needed.
+    //
+    // Each thread takes the next stash or character as soon as it is done with
+    // the last one, so one big stash does not hold up the others. The calling
+    // thread, which is already on the pool, takes part too and does all of the
+    // work when there are no other threads to help.
+    template<typename T, typename Add>
+    NodeTable buildSubtrees(QThreadPool &pool, std::vector<T> list, Add add)
+    {
+        std::vector<NodeTable> subtrees(list.size());
+        std::atomic<size_t> next{0};
+        const auto work = [&]() {
+            for (size_t i = next++; i < list.size(); i = next++) {
+                add(subtrees[i], list[i]);
+            }
+        };
+
+        const auto threads = static_cast<size_t>(std::max(pool.maxThreadCount() - 1, 0));
+        const auto helpers = static_cast<std::ptrdiff_t>(std::min(threads, list.size()));
+        std::latch done(helpers);
+        for (std::ptrdiff_t i = 0; i < helpers; ++i) {
+            pool.start([&]() {
+                work();
+                done.count_down();
+            });
+        }
+        work();
+        done.wait();
+
+        NodeTable nodes;
+        std::vector<NodeTable::NodeId> children;
+        children.reserve(subtrees.size());
+        for (auto &subtree : subtrees) {
+            children.push_back(nodes.adopt(subtree, subtree.child(NodeTable::Root, 0)));
+        }
+        nodes.insertChildren(NodeTable::Root, 0, children);
+        return nodes;
+    }
+
+} // namespace
 
 TreeModel::TreeModel(QObject *parent)
     : QAbstractItemModel{parent}
-    , m_root{"Root", nullptr}
-    , m_characterRoot{m_root.addChild("Characters")}
-    , m_stashRoot{m_root.addChild("Stash Tabs")}
-{}
+    , m_characterRoot{m_nodes.addFolder(NodeTable::Root, "Characters")}
+    , m_stashRoot{m_nodes.addFolder(NodeTable::Root, "Stash Tabs")}
+    , m_details{DETAILS_CACHE_SIZE}
+{
+    m_batchTimer.setSingleShot(true);
+    m_batchTimer.setInterval(BATCH_DELAY_MSECS);
+    connect(&m_batchTimer, &QTimer::timeout, this, &TreeModel::buildPending);
+}
 
 QModelIndex TreeModel::index(int row, int column, const QModelIndex& parent) const
 {
-    const TreeNode* parent_node = getNode(parent);
-    if (parent_node) {
-        const TreeNode* child_node = parent_node->child(row);
-        if (child_node) {
-            return createIndex(row, column, child_node);
-        }
+    const NodeTable::NodeId child = m_nodes.child(getNode(parent), row);
+    if (child != NodeTable::Invalid) {
+        return createIndex(row, column, static_cast<quintptr>(child));
     }
     return QModelIndex();
 }
 
 QModelIndex TreeModel::parent(const QModelIndex& index) const
 {
-    const TreeNode* child = getNode(index);
-    if (child != &m_root) {
-        const TreeNode* parent = child->parent();
-        if (parent != &m_root) {
-            return createIndex(parent->row(), 0, parent);
-        }
+    const NodeTable::NodeId child = getNode(index);
+    if (child != NodeTable::Root) {
+        return indexOf(m_nodes.parent(child));
     }
     return QModelIndex();
 }
@@ -40,28 +121,262 @@ QVariant TreeModel::headerData(int section, Qt::Orientation orientation, int rol
     Q_UNUSED(orientation);
     if (role == Qt::DisplayRole) {
         if ((section >= 0) && (section < ItemData::ColumnCount)) {
-            return ItemData::Columns[section].name;
+            return ItemData::columnName(section);
         }
     }
     return QVariant();
 }
 
+ItemData::Details TreeModel::getDetails(const QModelIndex &index) const
+{
+    const NodeTable::NodeId id = getNode(index);
+    if (const ItemData::Details *details = m_details.object(id)) {
+        return *details;
+    }
+    auto details = m_nodes.details(id);
+    if (!details) {
+        return {};
+    }
+    m_details.insert(id, new ItemData::Details(*details));
+    return *details;
+}
+
+void TreeModel::addStash(const poe::StashTab &stash)
+{
+    m_pendingStashes.push_back(stash);
+    if (!m_batchTimer.isActive()) {
+        m_batchTimer.start();
+    }
+}
+
 void TreeModel::addCharacter(const poe::Character &character)
 {
-    const int k = m_characterRoot.childCount();
-    const QModelIndex index = createIndex(0, 0, &m_characterRoot);
+    m_pendingCharacters.push_back(character);
+    if (!m_batchTimer.isActive()) {
+        m_batchTimer.start();
+    }
+}
 
-    beginInsertRows(index, k, k);
-    m_characterRoot.addChild(character);
-    endInsertRows();
+void TreeModel::addStashes(std::vector<poe::StashTab> stashes)
+{
+    m_pendingStashes.insert(m_pendingStashes.end(),
+                            std::make_move_iterator(stashes.begin()),
+                            std::make_move_iterator(stashes.end()));
+    buildPending();
 }
 
-void TreeModel::addStash(const poe::StashTab &stash)
+void TreeModel::addCharacters(std::vector<poe::Character> characters)
 {
-    const int k = m_stashRoot.childCount();
-    const QModelIndex index = createIndex(0, 0, &m_stashRoot);
+    m_pendingCharacters.insert(m_pendingCharacters.end(),
+                               std::make_move_iterator(characters.begin()),
+                               std::make_move_iterator(characters.end()));
+    buildPending();
+}
+
+void TreeModel::buildPending()
+{
+    // A running build picks up whatever is pending when it finishes.
+    if (m_building || (m_pendingCharacters.empty() && m_pendingStashes.empty())) {
+        return;
+    }
+    m_batchTimer.stop();
+    m_building = true;
+
+    auto build = [this,
+                  characters = std::move(m_pendingCharacters),
+                  stashes = std::move(m_pendingStashes)]() mutable {
+        // This runs on the build pool.
+        keepLatest(characters);
+        keepLatest(stashes);
+        std::stable_sort(characters.begin(), characters.end(), [](const auto &a, const auto &b) {
+            return a.name < b.name;
+        });
+        std::stable_sort(stashes.begin(), stashes.end(), [](const auto &a, const auto &b) {
+            return a.index.value_or(UNKNOWN_INDEX) < b.index.value_or(UNKNOWN_INDEX);
+        });
+
+        const auto add_character = [](NodeTable &nodes, const poe::Character &character) {
+            nodes.addCharacter(NodeTable::Root, character);
+        };
+        const auto add_stash = [](NodeTable &nodes, const poe::StashTab &stash) {
+            nodes.addStash(NodeTable::Root, stash);
+        };
+        auto character_nodes = buildSubtrees(m_buildPool, std::move(characters), add_character);
+        auto stash_nodes = buildSubtrees(m_buildPool, std::move(stashes), add_stash);
 
-    beginInsertRows(index, k, k);
-    m_stashRoot.addChild(stash);
+        QMetaObject::invokeMethod(
+            this,
+            [this,
+             character_nodes = std::move(character_nodes),
+             stash_nodes = std::move(stash_nodes)]() mutable {
+                insertBatch(std::move(character_nodes), std::move(stash_nodes));
+            },
+            Qt::QueuedConnection);
+    };
+    m_pendingCharacters.clear();
+    m_pendingStashes.clear();
+    m_buildPool.start(std::move(build));
+}
+
+void TreeModel::insertBatch(NodeTable characters, NodeTable stashes)
+{
+    mergeBatch(m_characterRoot, m_characterIds, characters);
+    mergeBatch(m_stashRoot, m_stashIds, stashes);
+    compactIfNeeded();
+
+    m_building = false;
+    buildPending();
+}
+
+void TreeModel::mergeBatch(NodeTable::NodeId folder,
+                           QHash<QString, NodeTable::NodeId> &ids,
+                           NodeTable &batch)
+{
+    std::vector<NodeTable::NodeId> added;
+    for (int row = 0; row < batch.childCount(NodeTable::Root); ++row) {
+        const NodeTable::NodeId from = batch.child(NodeTable::Root, row);
+        const auto it = ids.constFind(batch.key(from));
+        if (it != ids.constEnd()) {
+            updateNode(it.value(), batch, from);
+        } else {
+            added.push_back(from);
+        }
+    }
+    if (added.empty()) {
+        return;
+    }
+
+    // New stashes and characters are added after the ones already there.
+    const int first = m_nodes.childCount(folder);
+    beginInsertRows(indexOf(folder), first, first + static_cast<int>(added.size()) - 1);
+    for (auto &from : added) {
+        const QString key = batch.key(from);
+        from = m_nodes.adopt(batch, from);
+        ids.insert(key, from);
+    }
+    m_nodes.insertChildren(folder, first, added);
     endInsertRows();
 }
+
+void TreeModel::updateNode(NodeTable::NodeId id, NodeTable &batch, NodeTable::NodeId from)
+{
+    const bool changed = m_nodes.replacePayload(id, batch, from);
+    if (changed) {
+        m_details.remove(id);
+        const QModelIndex index = indexOf(id);
+        emit dataChanged(index, index.siblingAtColumn(ItemData::ColumnCount - 1));
+    }
+
+    // Socketed items are part of an item, so they can only change with it.
+    if (changed || (m_nodes.kind(id) != NodeTable::Kind::Item)) {
+        updateChildren(id, batch, from);
+    }
+}
+
+void TreeModel::updateChildren(NodeTable::NodeId parent, NodeTable &batch, NodeTable::NodeId from)
+{
+    const int old_count = m_nodes.childCount(parent);
+    const int new_count = batch.childCount(from);
+    if ((old_count == 0) && (new_count == 0)) {
+        return;
+    }
+
+    QHash<QString, int> old_rows;
+    old_rows.reserve(old_count);
+    for (int row = 0; row < old_count; ++row) {
+        old_rows.insert(m_nodes.key(m_nodes.child(parent, row)), row);
+    }
+
+    // Children that are still there in the same order are kept. Anything that
+    // moved past another child is removed and added again.
+    std::vector<NodeTable::NodeId> matches(static_cast<size_t>(new_count), NodeTable::Invalid);
+    std::vector<bool> kept(static_cast<size_t>(old_count), false);
+    int last_row = -1;
+    for (int row = 0; row < new_count; ++row) {
+        const int old_row = old_rows.value(batch.key(batch.child(from, row)), -1);
+        if (old_row > last_row) {
+            matches[row] = m_nodes.child(parent, old_row);
+            kept[old_row] = true;
+            last_row = old_row;
+        }
+    }
+
+    // Rows are removed from the end so that the rows before them stay put.
+    const QModelIndex index = indexOf(parent);
+    for (int last = old_count - 1; last >= 0; --last) {
+        if (kept[last]) {
+            continue;
+        }
+        int first = last;
+        while ((first > 0) && !kept[first - 1]) {
+            --first;
+        }
+        beginRemoveRows(index, first, last);
+        m_nodes.removeChildren(parent, first, last - first + 1);
+        endRemoveRows();
+        last = first;
+    }
+
+    // Now the kept children are in order, and new ones go in between them.
+    int next = 0;
+    while (next < new_count) {
+        if (matches[next] != NodeTable::Invalid) {
+            ++next;
+            continue;
+        }
+        std::vector<NodeTable::NodeId> added;
+        const int first = next;
+        while ((next < new_count) && (matches[next] == NodeTable::Invalid)) {
+            added.push_back(m_nodes.adopt(batch, batch.child(from, next)));
+            ++next;
+        }
+        beginInsertRows(index, first, next - 1);
+        m_nodes.insertChildren(parent, first, added);
+        endInsertRows();
+    }
+
+    for (int row = 0; row < new_count; ++row) {
+        if (matches[row] != NodeTable::Invalid) {
+            updateNode(matches[row], batch, batch.child(from, row));
+        }
+    }
+}
+
+void TreeModel::compactIfNeeded()
+{
+    if (!m_nodes.needsCompaction()) {
+        return;
+    }
+
+    // Compacting changes the ids that indexes hold, but not their rows. The
+    // folders were added first, so their ids stay the same.
+    emit layoutAboutToBeChanged();
+    const std::vector<NodeTable::NodeId> remap = m_nodes.compact();
+    const QModelIndexList old_indexes = persistentIndexList();
+    QModelIndexList new_indexes;
+    new_indexes.reserve(old_indexes.size());
+    for (const QModelIndex &index : old_indexes) {
+        const NodeTable::NodeId id = remap[getNode(index)];
+        if (id == NodeTable::Invalid) {
+            new_indexes.append(QModelIndex());
+        } else {
+            new_indexes.append(createIndex(index.row(), index.column(), static_cast<quintptr>(id)));
+        }
+    }
+    changePersistentIndexList(old_indexes, new_indexes);
+    m_details.clear();
+    for (auto *ids : {&m_characterIds, &m_stashIds}) {
+        for (auto &id : *ids) {
+            id = remap[id];
+        }
+    }
+    emit layoutChanged();
+}
+
+QModelIndex TreeModel::indexOf(NodeTable::NodeId id) const
+{
+    if (id == NodeTable::Root) {
+        return QModelIndex();
+    }
+    return createIndex(m_nodes.row(id), 0, static_cast<quintptr>(id));
+}
@@ -4,11 +4,17 @@
 #pragma once
 
 #include "model/itemdata.h"
-#include "model/treenode.h"
+#include "model/nodetable.h"
 #include <poe/types/character.h>
 #include <poe/types/stashtab.h>
 
 #include <QAbstractItemModel>
+#include <QCache>
+#include <QHash>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <vector>
 
 class TreeModel : public QAbstractItemModel {
     Q_OBJECT
@@ -30,7 +36,7 @@ public:
     
     // Returns the number of rows under the given parent. When the parent is valid it means that rowCount is returning the number of children of parent.
     inline int rowCount(const QModelIndex& parent = QModelIndex()) const override {
-        return getNode(parent)->childCount();
+        return m_nodes.childCount(getNode(parent));
     }
 
     // Returns the number of columns for the children of the given parent.
@@ -42,29 +48,82 @@ public:
     // Returns the data stored under the given role for the item referred to by the index.
     inline QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override
     {
-        return (index.isValid() && (role == Qt::DisplayRole)) ? getNode(index)->data(index.column())
-                                                              : QVariant();
+        return (index.isValid() && (role == Qt::DisplayRole))
+                   ? m_nodes.data(getNode(index), index.column())
+                   : QVariant();
     }
 
     inline bool hasChildren(const QModelIndex &parent = QModelIndex()) const override {
-        return getNode(parent)->hasChildren();
+        return m_nodes.childCount(getNode(parent)) > 0;
     }
 
     // Returns the data for the given role and section in the header with the specified orientation.
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
-    inline const TreeNode* getNode(const QModelIndex& index) const {
-        return index.isValid() && index.internalPointer()
-                   ? static_cast<TreeNode *>(index.internalPointer())
-                   : &m_root;
+    // Indexes store the id of their node, and the invalid index is the root.
+    inline NodeTable::NodeId getNode(const QModelIndex &index) const
+    {
+        return index.isValid() ? static_cast<NodeTable::NodeId>(index.internalId())
+                               : NodeTable::Root;
     }
 
+    // Returns the item at the given index, or nullptr if it is not an item.
+    inline const ItemData *getItem(const QModelIndex &index) const
+    {
+        return m_nodes.item(getNode(index));
+    }
+
+    // The node table and the index of a node in it, for models layered on top
+    // of this one.
+    inline const NodeTable &nodes() const { return m_nodes; }
+    QModelIndex indexOf(NodeTable::NodeId id) const;
+
+    // Returns the tooltip text of the item at the given index. Only the most
+    // recently used items keep theirs.
+    ItemData::Details getDetails(const QModelIndex &index) const;
+
 public slots:
+    // Single stashes and characters arrive in bursts while they are refreshed,
+    // so they are held for a short time and then inserted together.
     void addStash(const poe::StashTab &stash);
     void addCharacter(const poe::Character &character);
 
+    // Builds the subtrees on another thread and inserts each list as one
+    // range of rows, sorted by stash index or character name. A stash or
+    // character that is already in the tree is updated in place instead, so
+    // views keep their expanded and selected rows across a refresh.
+    void addStashes(std::vector<poe::StashTab> stashes);
+    void addCharacters(std::vector<poe::Character> characters);
+
 private:
-    TreeNode m_root;
-    TreeNode &m_characterRoot;
-    TreeNode &m_stashRoot;
+    void buildPending();
+    void insertBatch(NodeTable characters, NodeTable stashes);
+    void mergeBatch(NodeTable::NodeId folder,
+                    QHash<QString, NodeTable::NodeId> &ids,
+                    NodeTable &batch);
+    void updateNode(NodeTable::NodeId id, NodeTable &batch, NodeTable::NodeId from);
+    void updateChildren(NodeTable::NodeId parent, NodeTable &batch, NodeTable::NodeId from);
+    void compactIfNeeded();
+
+    NodeTable m_nodes;
+    const NodeTable::NodeId m_characterRoot;
+    const NodeTable::NodeId m_stashRoot;
+
+    // Nodes of the stashes and characters in the tree, by their id.
+    QHash<QString, NodeTable::NodeId> m_characterIds;
+    QHash<QString, NodeTable::NodeId> m_stashIds;
+
+    mutable QCache<NodeTable::NodeId, ItemData::Details> m_details;
+
+    // Stashes and characters waiting to be built. Only one batch is built at
+    // a time, so that batches are inserted in the order they arrived.
+    std::vector<poe::Character> m_pendingCharacters;
+    std::vector<poe::StashTab> m_pendingStashes;
+    QTimer m_batchTimer;
+    bool m_building{false};
+
+    // Builds run here, and each one spreads its stashes and characters over
+    // the other threads. This is last so that it waits for a running build
+    // before anything else is destroyed.
+    QThreadPool m_buildPool;
 };
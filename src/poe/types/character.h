@@ -9,6 +9,8 @@
 #include <poe/types/itemjeweldata.h>
 #include <poe/types/passivenode.h>
 
+#include "util/unknownkeys.h"
+
 #include <glaze/glaze.hpp>
 
 #include <QString>
@@ -39,11 +41,15 @@ namespace poe {
             std::unordered_map<QString, poe::ItemJewelData>
                 jewel_data; // dictionary of ItemJewelData the key is the string value of the x property of an item from the jewels array in this request
             std::optional<QString> alternate_ascendancy; // ? string Warden, Warlock, or Primalist
+
+            JSON_UNKNOWN_KEYS(poe::Character::Passives)
         };
 
         struct Metadata
         {
             std::optional<QString> version; // ? string game version for the character's realm
+
+            JSON_UNKNOWN_KEYS(poe::Character::Metadata)
         };
 
         inline bool operator<(const Character &other) const { return name < other.name; };
@@ -66,16 +72,22 @@ namespace poe {
         std::optional<std::vector<poe::Item>> jewels;     // ? array of Item
         std::optional<poe::Character::Passives> passives; // ? object
         std::optional<poe::Character::Metadata> metadata; // ? object
+
+        JSON_UNKNOWN_KEYS(poe::Character)
     };
 
     struct CharacterListWrapper
     {
         std::vector<poe::Character> characters;
+
+        JSON_UNKNOWN_KEYS(poe::CharacterListWrapper)
     };
 
     struct CharacterWrapper
     {
         std::optional<poe::Character> character;
+
+        JSON_UNKNOWN_KEYS(poe::CharacterWrapper)
     };
 
 } // namespace poe
@@ -105,4 +117,10 @@ struct glz::meta<poe::Character>
         "metadata",   &T::metadata // ? object
     );
     // clang-format on
+    static constexpr auto unknown_read = &T::unknownKey;
 };
+
+JSON_UNKNOWN_KEYS_META(poe::Character::Passives);
+JSON_UNKNOWN_KEYS_META(poe::Character::Metadata);
+JSON_UNKNOWN_KEYS_META(poe::CharacterListWrapper);
+JSON_UNKNOWN_KEYS_META(poe::CharacterWrapper);
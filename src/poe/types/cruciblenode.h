@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "util/unknownkeys.h"
+
 #include <Qstring>
 
 #include <optional>
@@ -26,6 +28,10 @@ namespace poe {
         std::optional<unsigned> orbitIndex; // ? uint	the node's position within the column
         std::vector<QString> out; //	array of string	node identifiers of nodes this one connects to
         std::vector<QString> in;  //	array of string	node identifiers of nodes connected to this one
+
+        JSON_UNKNOWN_KEYS(poe::CrucibleNode)
     };
 
 } // namespace poe
+
+JSON_UNKNOWN_KEYS_META(poe::CrucibleNode);
@@ -9,6 +9,7 @@
 #include <poe/types/itemsocket.h>
 
 #include "util/glaze_qt.h"
+#include "util/unknownkeys.h"
 
 static_assert(ACQUISITION_USE_GLAZE);
 
@@ -34,6 +35,8 @@ namespace poe {
             std::optional<bool> redeemer;
             std::optional<bool> hunter;
             std::optional<bool> warlord;
+
+            JSON_UNKNOWN_KEYS(poe::Item::Influences)
         };
 
         struct Rewards
@@ -41,12 +44,16 @@ namespace poe {
             QString label; // string
             std::unordered_map<QString, QString>
                 rewards; // dictionary of int the key is a string representing the type of reward.The value is the amount
+
+            JSON_UNKNOWN_KEYS(poe::Item::Rewards)
         };
 
         struct LogbookFaction
         {
             QString id;   // string Faction1, Faction2, Faction3, or Faction4
             QString name; // string
+
+            JSON_UNKNOWN_KEYS(poe::Item::LogbookFaction)
         };
 
         struct LogbookMods
@@ -54,12 +61,16 @@ namespace poe {
             QString name;                      // string area name
             poe::Item::LogbookFaction faction; // object
             std::vector<QString> mods;         // array of string
+
+            JSON_UNKNOWN_KEYS(poe::Item::LogbookMods)
         };
 
         struct UltimatumMods
         {
             QString type;  // string text used to display ultimatum icons
             unsigned tier; // uint
+
+            JSON_UNKNOWN_KEYS(poe::Item::UltimatumMods)
         };
 
         struct FlavorTextObject
@@ -67,6 +78,8 @@ namespace poe {
             QString id;
             QString type;
             QString class_;
+
+            JSON_UNKNOWN_KEYS(poe::Item::FlavorTextObject)
         };
         using FlavourTextItem = std::variant<std::string, FlavorTextObject>;
 
@@ -76,6 +89,8 @@ namespace poe {
             unsigned level;    // uint monster level required to progress
             unsigned progress; // uint
             unsigned total;    // uint
+
+            JSON_UNKNOWN_KEYS(poe::Item::IncubatingInfo)
         };
 
         struct ScourgedInfo
@@ -84,6 +99,8 @@ namespace poe {
             std::optional<unsigned> level;    // ? uint monster level required to progress
             std::optional<unsigned> progress; // ? uint
             std::optional<unsigned> total;    // ? uint
+
+            JSON_UNKNOWN_KEYS(poe::Item::ScourgedInfo)
         };
 
         using CrucibleNodeList = std::vector<CrucibleNode>;
@@ -93,9 +110,12 @@ namespace poe {
         {
             // TODO: WARNING: The nodes field is supposed to be an unordered_map,
             // but there's any issue with how php handles this field according to novynn, which
-            // can cause it to be an array.
+            // can cause it to be an array. Glaze picks the alternative from the first
+            // character of the value, so reading the variant never parses it twice.
             QString layout; // string URL to an image of the tree layout
             std::variant<CrucibleNodeList, CrucibleNodeMap> nodes;
+
+            JSON_UNKNOWN_KEYS(poe::Item::CrucibleInfo)
         };
 
         struct HybridInfo
@@ -105,6 +125,8 @@ namespace poe {
             std::optional<std::vector<poe::ItemProperty>> properties; // ? array of ItemProperty
             std::optional<std::vector<QString>> explicitMods;         // ? array of string
             std::optional<QString> secDescrText;                      // ? string
+
+            JSON_UNKNOWN_KEYS(poe::Item::HybridInfo)
         };
 
         struct ExtendedInfo
@@ -113,6 +135,8 @@ namespace poe {
             std::optional<std::vector<QString>> subcategories; // ? array of string
             std::optional<unsigned> prefixes;                  // ? uint
             std::optional<unsigned> suffixes;                  // ? uint
+
+            JSON_UNKNOWN_KEYS(poe::Item::ExtendedInfo)
         };
 
         inline bool operator<(const Item &other) const
@@ -209,6 +233,8 @@ namespace poe {
         std::optional<QString> inventoryId; // ? string
         std::optional<unsigned> socket;     // ? uint
         std::optional<QString> colour;      // ? string S, D, I, or G
+
+        JSON_UNKNOWN_KEYS(poe::Item)
     };
 
 } // namespace poe
@@ -223,4 +249,17 @@ struct glz::meta<poe::Item::FlavorTextObject>
         "class", &poe::Item::FlavorTextObject::class_
     );
     // clang-format on
+    static constexpr auto unknown_read = &poe::Item::FlavorTextObject::unknownKey;
 };
+
+JSON_UNKNOWN_KEYS_META(poe::Item::Influences);
+JSON_UNKNOWN_KEYS_META(poe::Item::Rewards);
+JSON_UNKNOWN_KEYS_META(poe::Item::LogbookFaction);
+JSON_UNKNOWN_KEYS_META(poe::Item::LogbookMods);
+JSON_UNKNOWN_KEYS_META(poe::Item::UltimatumMods);
+JSON_UNKNOWN_KEYS_META(poe::Item::IncubatingInfo);
+JSON_UNKNOWN_KEYS_META(poe::Item::ScourgedInfo);
+JSON_UNKNOWN_KEYS_META(poe::Item::CrucibleInfo);
+JSON_UNKNOWN_KEYS_META(poe::Item::HybridInfo);
+JSON_UNKNOWN_KEYS_META(poe::Item::ExtendedInfo);
+JSON_UNKNOWN_KEYS_META(poe::Item);
@@ -6,6 +6,8 @@
 #include <poe/types/passivegroup.h>
 #include <poe/types/passivenode.h>
 
+#include "util/unknownkeys.h"
+
 #include <QString>
 
 #include <optional>
@@ -23,6 +25,8 @@ namespace poe {
                 groups; // dictionary of PassiveGroup the key is the string value of the group id
             std::unordered_map<QString, poe::PassiveNode>
                 nodes; // dictionary of PassiveNode the key is the string value of the node identifier
+
+            JSON_UNKNOWN_KEYS(poe::ItemJewelData::Subgraph)
         };
 
         QString type;                                         // string
@@ -30,6 +34,11 @@ namespace poe {
         std::optional<unsigned> radiusMin;                    // ? uint
         std::optional<QString> radiusVisual;                  // ? string
         std::optional<poe::ItemJewelData::Subgraph> subgraph; // ? object only present on cluster jewels
+
+        JSON_UNKNOWN_KEYS(poe::ItemJewelData)
     };
 
 } // namespace poe
+
+JSON_UNKNOWN_KEYS_META(poe::ItemJewelData::Subgraph);
+JSON_UNKNOWN_KEYS_META(poe::ItemJewelData);
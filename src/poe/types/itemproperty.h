@@ -6,6 +6,8 @@
 #include <poe/types/displaymode.h>
 #include <poe/types/enums.h>
 
+#include "util/unknownkeys.h"
+
 #include <QString>
 
 #include <optional>
@@ -27,6 +29,10 @@ namespace poe {
         std::optional<QString> suffix;                // ? string
 
         QString render() const;
+
+        JSON_UNKNOWN_KEYS(poe::ItemProperty)
     };
 
 } // namespace poe
+
+JSON_UNKNOWN_KEYS_META(poe::ItemProperty);
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "util/unknownkeys.h"
+
 #include <QString>
 
 #include <optional>
@@ -16,6 +18,10 @@ namespace poe {
         unsigned group;                 // uint
         std::optional<QString> attr;    // ? string S, D, I, G, A, or DV
         std::optional<QString> sColour; // ? string R, G, B, W, A, or DV
+
+        JSON_UNKNOWN_KEYS(poe::ItemSocket)
     };
 
 } // namespace poe
+
+JSON_UNKNOWN_KEYS_META(poe::ItemSocket);
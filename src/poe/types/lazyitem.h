@@ -0,0 +1,136 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <poe/types/item.h>
+#include <poe/types/stashtab.h>
+
+#include "util/arena.h"
+#include "util/json.h"
+
+static_assert(ACQUISITION_USE_GLAZE);
+
+#include <QByteArray>
+#include <QString>
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace poe {
+
+    // Stored payloads were validated when they were received, so fields
+    // are decoded from them without failing on keys we don't know about.
+    constexpr auto LAZY_JSON_MODE = json::Mode::Permissive;
+
+    // An item kept as a slice of the JSON payload it arrived in. The payload
+    // is shared, not copied, and fields are only decoded when asked for.
+    class LazyItem
+    {
+    public:
+        LazyItem(const QByteArray &source, std::string_view slice)
+            : m_source(source)
+            , m_offset(slice.data() - source.constData())
+            , m_size(static_cast<qsizetype>(slice.size()))
+        {}
+
+        inline const QByteArray &source() const { return m_source; }
+
+        inline std::string_view json() const
+        {
+            return {m_source.constData() + m_offset, static_cast<size_t>(m_size)};
+        }
+
+        // Decodes any struct whose fields are a subset of the item's.
+        template<typename T>
+        bool decode(T &output) const
+        {
+            return json::parse_into<LAZY_JSON_MODE>(output, json());
+        }
+
+    private:
+        QByteArray m_source;
+        qsizetype m_offset;
+        qsizetype m_size;
+    };
+
+    // The top level of a stash payload, with items left undecoded. This is a
+    // transient scan result, so its containers can come from a parse arena.
+    struct LazyStashTab
+    {
+        QString id;
+        std::optional<QString> folder;
+        std::optional<QString> parent;
+        QString name;
+        QString type;
+        std::optional<unsigned> index;
+        glz::raw_json_view metadata;
+        std::optional<glz::raw_json_view> children;
+        std::optional<arena::vector<glz::raw_json_view>> items;
+    };
+
+    struct LazyStashWrapper
+    {
+        std::optional<poe::LazyStashTab> stash;
+    };
+
+    inline std::vector<LazyItem> toLazyItems(const QByteArray &source,
+                                             const arena::vector<glz::raw_json_view> &slices)
+    {
+        std::vector<LazyItem> items;
+        items.reserve(slices.size());
+        for (const auto &slice : slices) {
+            items.emplace_back(source, slice.str);
+        }
+        return items;
+    }
+
+    // Scans a stash payload for its items without decoding them. The returned
+    // items don't depend on any parse arena that was active during the scan.
+    inline std::optional<std::vector<LazyItem>> scanStashItems(const QByteArray &data)
+    {
+        LazyStashWrapper wrapper;
+        if (!json::parse_into<LAZY_JSON_MODE>(wrapper, data) || !wrapper.stash) {
+            return std::nullopt;
+        }
+        if (!wrapper.stash->items) {
+            return std::vector<LazyItem>{};
+        }
+        return toLazyItems(data, wrapper.stash->items.value());
+    }
+
+    // Decodes a scanned stash in full. Each item is decoded from its own slice,
+    // and the slices are returned as well, so that the payload is only scanned
+    // once even when the raw items are needed too.
+    template<json::Mode M>
+    bool decodeStash(const QByteArray &source,
+                     const LazyStashTab &scan,
+                     poe::StashTab &stash,
+                     std::vector<LazyItem> &items)
+    {
+        stash.id = scan.id;
+        stash.folder = scan.folder;
+        stash.parent = scan.parent;
+        stash.name = scan.name;
+        stash.type = scan.type;
+        stash.index = scan.index;
+        if (!scan.metadata.str.empty() && !json::parse_into<M>(stash.metadata, scan.metadata.str)) {
+            return false;
+        }
+        if (scan.children && !json::parse_into<M>(stash.children.emplace(), scan.children->str)) {
+            return false;
+        }
+        if (scan.items) {
+            items = toLazyItems(source, scan.items.value());
+            auto &decoded = stash.items.emplace(items.size());
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (!json::parse_into<M>(decoded[i], items[i].json())) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+} // namespace poe
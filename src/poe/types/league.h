@@ -5,6 +5,8 @@
 
 #include <poe/types/leaguerule.h>
 
+#include "util/unknownkeys.h"
+
 #include <QString>
 
 #include <optional>
@@ -21,6 +23,8 @@ namespace poe {
             QString id; // string the league category, e.g.Affliction
             std::optional<bool>
                 current; // ? bool set for the active challenge leagues; always true if present
+
+            JSON_UNKNOWN_KEYS(poe::League::Category)
         };
 
         QString id;                                        // string the league's name
@@ -40,11 +44,19 @@ namespace poe {
         std::optional<bool> delveEvent;    // ? bool always true if present
         std::optional<bool> ancestorEvent; // ? bool always true if present
         std::optional<bool> leagueEvent;   // ? bool always true if present
+
+        JSON_UNKNOWN_KEYS(poe::League)
     };
 
     struct LeagueListWrapper
     {
         std::vector<poe::League> leagues;
+
+        JSON_UNKNOWN_KEYS(poe::LeagueListWrapper)
     };
 
 } // namespace poe
+
+JSON_UNKNOWN_KEYS_META(poe::League::Category);
+JSON_UNKNOWN_KEYS_META(poe::League);
+JSON_UNKNOWN_KEYS_META(poe::LeagueListWrapper);
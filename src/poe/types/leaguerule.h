@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "util/unknownkeys.h"
+
 #include <QString>
 
 #include <optional>
@@ -16,6 +18,10 @@ namespace poe {
         QString id;                         // string examples : Hardcore, NoParties(SSF)
         QString name;                       // string
         std::optional<QString> description; // ? string
+
+        JSON_UNKNOWN_KEYS(poe::LeagueRule)
     };
 
 } // namespace poe
+
+JSON_UNKNOWN_KEYS_META(poe::LeagueRule);
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "util/unknownkeys.h"
+
 #include <QString>
 
 #include <optional>
@@ -20,6 +22,10 @@ namespace poe {
         std::optional<bool> isProxy;  // ? bool always true if present
         std::optional<QString> proxy; // ? string identifier of the placeholder node
         std::vector<QString> nodes; // array of string the node identifiers associated with this group;
+
+        JSON_UNKNOWN_KEYS(poe::PassiveGroup)
     };
 
 } // namespace poe
+
+JSON_UNKNOWN_KEYS_META(poe::PassiveGroup);
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "util/unknownkeys.h"
+
 #include <QString>
 
 #include <optional>
@@ -19,6 +21,8 @@ namespace poe {
             unsigned effect;                                  // uint effect hash
             std::vector<QString> stats;                       // array of string stat descriptions
             std::optional<std::vector<QString>> reminderText; // ? array of string
+
+            JSON_UNKNOWN_KEYS(poe::PassiveNode::Mastery)
         };
 
         struct ClusterJewel
@@ -28,6 +32,8 @@ namespace poe {
             std::optional<unsigned> index;  // ? uint
             std::optional<QString> proxy;   // ? uint the proxy node identifier
             std::optional<QString> parent;  // ? uint the parent node identifier
+
+            JSON_UNKNOWN_KEYS(poe::PassiveNode::ClusterJewel)
         };
 
         std::optional<QString> skill; // ? uint skill hash TODO: WARNING: supposed to be a ?uint
@@ -70,6 +76,12 @@ namespace poe {
         std::optional<unsigned> orbitIndex; // ? uint the index of this node in the group's orbit
         std::vector<QString> out; // array of string node identifiers of nodes this one connects to
         std::vector<QString> in;  // array of string node identifiers of nodes connected to this one
+
+        JSON_UNKNOWN_KEYS(poe::PassiveNode)
     };
 
 } // namespace poe
+
+JSON_UNKNOWN_KEYS_META(poe::PassiveNode::Mastery);
+JSON_UNKNOWN_KEYS_META(poe::PassiveNode::ClusterJewel);
+JSON_UNKNOWN_KEYS_META(poe::PassiveNode);
@@ -7,6 +7,8 @@
 
 #include <poe/types/item.h>
 
+#include "util/unknownkeys.h"
+
 #include <glaze/glaze.hpp>
 
 #include <QString>
@@ -30,15 +32,21 @@ namespace poe {
                 int tier;
                 int series;
                 int index;
+
+                JSON_UNKNOWN_KEYS(poe::StashTab::Metadata::Map)
             };
 
             std::optional<bool> public_; // ? bool always true if present
             std::optional<bool> folder;  // ? bool always true if present
             std::optional<QString>
                 colour; // ? string 6 digit hex colour (NOTE: might be only 2 or 4 characters).
+            // The layout is undocumented and only passed through, so it stays
+            // raw_json. Glaze copies the slice without parsing it.
             glz::raw_json layout;             // TODO: undocumented!
             std::optional<int> items;         // TODO: undocumented!
             poe::StashTab::Metadata::Map map; // TODO: undocumented!
+
+            JSON_UNKNOWN_KEYS(poe::StashTab::Metadata)
         };
 
         inline bool operator<(const StashTab &other) const
@@ -57,16 +65,22 @@ namespace poe {
         poe::StashTab::Metadata metadata; // metadata object
         std::optional<std::vector<poe::StashTab>> children; // ? array of StashTab
         std::optional<std::vector<poe::Item>> items;        // ? array of Item
+
+        JSON_UNKNOWN_KEYS(poe::StashTab)
     };
 
     struct StashListWrapper
     {
         std::vector<poe::StashTab> stashes;
+
+        JSON_UNKNOWN_KEYS(poe::StashListWrapper)
     };
 
     struct StashWrapper
     {
         std::optional<poe::StashTab> stash;
+
+        JSON_UNKNOWN_KEYS(poe::StashWrapper)
     };
 
 }; // namespace poe
@@ -84,4 +98,10 @@ struct glz::meta<poe::StashTab::Metadata>
         "map",    &poe::StashTab::Metadata::map
     );
     // clang-format on
+    static constexpr auto unknown_read = &poe::StashTab::Metadata::unknownKey;
 };
+
+JSON_UNKNOWN_KEYS_META(poe::StashTab::Metadata::Map);
+JSON_UNKNOWN_KEYS_META(poe::StashTab);
+JSON_UNKNOWN_KEYS_META(poe::StashListWrapper);
+JSON_UNKNOWN_KEYS_META(poe::StashWrapper);
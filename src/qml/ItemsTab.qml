@@ -47,12 +47,57 @@ Item {
             SplitView.fillHeight: true
             SplitView.minimumWidth: 200
 
+            TextField {
+                id: itemsFilter
+                Layout.fillWidth: true
+
+                property bool valid: true
+
+                placeholderText: "Filter items, e.g. rare base:belt ilvl>=84 mod:life mod:resistance>=2"
+                color: valid ? palette.text : "red"
+
+                // The filter is applied once typing pauses, not on every key.
+                onTextEdited: filterTimer.restart()
+
+                Timer {
+                    id: filterTimer
+                    interval: 300
+                    onTriggered: {
+                        itemsFilter.valid = App.filterItems(itemsFilter.text)
+                    }
+                }
+            }
+
             HorizontalHeaderView {
                 id: itemsHeader
                 Layout.fillWidth: true
 
                 clip: true
                 syncView: itemsView
+
+                property int sortColumn: -1
+                property int sortOrder: Qt.AscendingOrder
+
+                // Clicking a column sorts by it, and clicking it again reverses the order.
+                // The header scrolls with the view, so the tap is mapped into its content.
+                TapHandler {
+                    onTapped: (eventPoint) => {
+                        const position = itemsHeader.contentItem.mapFromItem(itemsHeader,
+                                                                             eventPoint.position)
+                        const column = itemsHeader.cellAtPosition(position).x
+                        if (column < 0) {
+                            return
+                        }
+                        if (column === itemsHeader.sortColumn) {
+                            itemsHeader.sortOrder = (itemsHeader.sortOrder === Qt.AscendingOrder)
+                                ? Qt.DescendingOrder : Qt.AscendingOrder
+                        } else {
+                            itemsHeader.sortColumn = column
+                            itemsHeader.sortOrder = Qt.AscendingOrder
+                        }
+                        App.itemsModel.sort(column, itemsHeader.sortOrder)
+                    }
+                }
             }
 
             TreeView {
@@ -0,0 +1,81 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Arena allocation for the transient results of parsing a payload.
+//
+// Containers declared with arena::vector bind to the calling thread's current
+// resource when they are created. While a ParseArena is alive on a thread,
+// that is the arena, so every container glaze creates while parsing draws from
+// it, and the memory is released in one shot when the arena goes away.
+// Otherwise they use the general heap.
+//
+// Anything created inside an arena must not outlive it. Only use these types
+// for scan and summary results that are discarded after the parse. Qt
+// containers are not allocator-aware, so QString contents stay on the heap.
+
+namespace arena {
+
+    inline thread_local std::pmr::memory_resource *t_resource = std::pmr::new_delete_resource();
+
+    inline std::pmr::memory_resource *current()
+    {
+        return t_resource;
+    }
+
+    template<typename T>
+    class Allocator : public std::pmr::polymorphic_allocator<T>
+    {
+    public:
+        Allocator() noexcept
+            : std::pmr::polymorphic_allocator<T>(current())
+        {}
+
+        Allocator(std::pmr::memory_resource *resource) noexcept
+            : std::pmr::polymorphic_allocator<T>(resource)
+        {}
+
+        template<typename U>
+        Allocator(const Allocator<U> &other) noexcept
+            : std::pmr::polymorphic_allocator<T>(other.resource())
+        {}
+
+        // Copies bind to whatever resource is current, like new containers do.
+        Allocator select_on_container_copy_construction() const { return Allocator(); }
+    };
+
+    template<typename T>
+    using vector = std::vector<T, Allocator<T>>;
+
+    class ParseArena
+    {
+    public:
+        // The arena starts with a buffer sized from the payload, so most
+        // parses don't need to go back to the heap for more.
+        explicit ParseArena(size_t payload_size)
+            : m_resource(std::max(MINIMUM_SIZE, payload_size / PAYLOAD_BYTES_PER_ARENA_BYTE))
+            , m_previous(t_resource)
+        {
+            t_resource = &m_resource;
+        }
+
+        ~ParseArena() { t_resource = m_previous; }
+
+        ParseArena(const ParseArena &) = delete;
+        ParseArena &operator=(const ParseArena &) = delete;
+
+    private:
+        static constexpr size_t MINIMUM_SIZE = 4096;
+        static constexpr size_t PAYLOAD_BYTES_PER_ARENA_BYTE = 4;
+
+        std::pmr::monotonic_buffer_resource m_resource;
+        std::pmr::memory_resource *m_previous;
+    };
+
+} // namespace arena
@@ -10,9 +10,15 @@
 #include <QByteArray>
 #include <QDateTime>
 #include <QString>
+#include <QStringView>
+#include <QTimeZone>
 
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 // This is a helper define to avoid Qt Creator's warnings that this header is unused.
@@ -31,6 +37,16 @@ constexpr bool ACQUISITION_USE_GLAZE = true;
 //  - std::unordered_map<QByteArray,T>
 //;
 // WARNING: this only works with the two-argument forms of map and unordered_map.
+//
+// Strings are read by letting glaze find the raw contents between the quotes,
+// which are then unescaped and converted straight into the Qt container in a
+// single pass. Strings are written by encoding into a reused per-thread buffer
+// that glaze escapes into its output.
+//
+// The same types are also supported in BEVE, glaze's binary format. Strings
+// are stored as UTF-8 and read as a view of the input, like JSON strings, so
+// they are converted straight from the buffer. Dates are stored as
+// milliseconds since the epoch.
 
 namespace {
 
@@ -55,6 +71,288 @@ namespace {
     template<template<typename, typename> class Map, typename Key, typename T>
     constexpr bool is_supported_map_with_qt_key = is_qt_key<Key> && is_supported_map<Map, Key, T>;
 
+    constexpr char16_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+    // Returns true if any of the eight bytes is non-ASCII or a backslash.
+    inline bool has_special_byte(uint64_t chunk)
+    {
+        constexpr uint64_t ones = 0x0101010101010101ULL;
+        constexpr uint64_t highs = 0x8080808080808080ULL;
+        const uint64_t backslashes = chunk ^ (ones * '\\');
+        return ((chunk & highs) | ((backslashes - ones) & ~backslashes & highs)) != 0;
+    }
+
+    inline int hex_value(char c)
+    {
+        if ((c >= '0') && (c <= '9')) {
+            return c - '0';
+        } else if ((c >= 'a') && (c <= 'f')) {
+            return c - 'a' + 10;
+        } else if ((c >= 'A') && (c <= 'F')) {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    // Decodes the four hex digits of a \u escape, or returns -1.
+    inline int32_t decode_hex4(const char *p)
+    {
+        int32_t unit = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int digit = hex_value(p[i]);
+            if (digit < 0) {
+                return -1;
+            }
+            unit = (unit << 4) | digit;
+        }
+        return unit;
+    }
+
+    // Decodes one simple escape character, or returns zero.
+    inline char16_t decode_escape(char c)
+    {
+        switch (c) {
+        case '"':
+            return u'"';
+        case '\\':
+            return u'\\';
+        case '/':
+            return u'/';
+        case 'b':
+            return u'\b';
+        case 'f':
+            return u'\f';
+        case 'n':
+            return u'\n';
+        case 'r':
+            return u'\r';
+        case 't':
+            return u'\t';
+        default:
+            return 0;
+        }
+    }
+
+    // Decodes the raw contents of a JSON string straight into UTF-16. Runs of
+    // ASCII are widened eight bytes at a time; escapes and multi-byte UTF-8 are
+    // handled as they are found. Invalid UTF-8 becomes U+FFFD, like it does in
+    // QString::fromUtf8(). Returns false on a malformed escape.
+    inline bool decode_json_string(std::string_view raw, QString &output)
+    {
+        // A JSON string never has more UTF-16 code units than it has bytes.
+        QString buffer(static_cast<qsizetype>(raw.size()), Qt::Uninitialized);
+        char16_t *const begin = reinterpret_cast<char16_t *>(buffer.data());
+        char16_t *out = begin;
+
+        const char *p = raw.data();
+        const char *const end = p + raw.size();
+        while (p < end) {
+            while ((end - p) >= 8) {
+                uint64_t chunk;
+                std::memcpy(&chunk, p, sizeof(chunk));
+                if (has_special_byte(chunk)) {
+                    break;
+                }
+                for (int i = 0; i < 8; ++i) {
+                    out[i] = static_cast<char16_t>(p[i]);
+                }
+                out += 8;
+                p += 8;
+            }
+            if (p == end) {
+                break;
+            }
+
+            const auto c = static_cast<unsigned char>(*p);
+            if (c == '\\') {
+                if ((end - p) < 2) {
+                    return false;
+                }
+                if (p[1] == 'u') {
+                    // Escaped code units are already UTF-16, including surrogates.
+                    const int32_t unit = ((end - p) >= 6) ? decode_hex4(p + 2) : -1;
+                    if (unit < 0) {
+                        return false;
+                    }
+                    *out++ = static_cast<char16_t>(unit);
+                    p += 6;
+                } else {
+                    const char16_t unit = decode_escape(p[1]);
+                    if (unit == 0) {
+                        return false;
+                    }
+                    *out++ = unit;
+                    p += 2;
+                }
+                continue;
+            }
+            if (c < 0x80) {
+                *out++ = c;
+                ++p;
+                continue;
+            }
+
+            // Decode a multi-byte UTF-8 sequence.
+            int length;
+            char32_t code_point;
+            if ((c & 0xE0) == 0xC0) {
+                length = 2;
+                code_point = c & 0x1F;
+            } else if ((c & 0xF0) == 0xE0) {
+                length = 3;
+                code_point = c & 0x0F;
+            } else if ((c & 0xF8) == 0xF0) {
+                length = 4;
+                code_point = c & 0x07;
+            } else {
+                *out++ = REPLACEMENT_CHARACTER;
+                ++p;
+                continue;
+            }
+            bool valid = (end - p) >= length;
+            for (int i = 1; valid && (i < length); ++i) {
+                const auto next = static_cast<unsigned char>(p[i]);
+                valid = (next & 0xC0) == 0x80;
+                code_point = (code_point << 6) | (next & 0x3F);
+            }
+            constexpr char32_t minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+            valid = valid && (code_point >= minimum[length]) && (code_point <= 0x10FFFF)
+                    && ((code_point < 0xD800) || (code_point > 0xDFFF));
+            if (!valid) {
+                *out++ = REPLACEMENT_CHARACTER;
+                ++p;
+                continue;
+            }
+            if (code_point >= 0x10000) {
+                code_point -= 0x10000;
+                *out++ = static_cast<char16_t>(0xD800 + (code_point >> 10));
+                *out++ = static_cast<char16_t>(0xDC00 + (code_point & 0x3FF));
+            } else {
+                *out++ = static_cast<char16_t>(code_point);
+            }
+            p += length;
+        }
+
+        buffer.truncate(out - begin);
+        output = std::move(buffer);
+        return true;
+    }
+
+    inline char *encode_utf8(char32_t code_point, char *out)
+    {
+        if (code_point < 0x80) {
+            *out++ = static_cast<char>(code_point);
+        } else if (code_point < 0x800) {
+            *out++ = static_cast<char>(0xC0 | (code_point >> 6));
+            *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+        } else if (code_point < 0x10000) {
+            *out++ = static_cast<char>(0xE0 | (code_point >> 12));
+            *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+        } else {
+            *out++ = static_cast<char>(0xF0 | (code_point >> 18));
+            *out++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        return out;
+    }
+
+    // Unescapes the raw contents of a JSON string into UTF-8. Text between
+    // escapes is copied as-is. Returns false on a malformed escape.
+    inline bool decode_json_string(std::string_view raw, QByteArray &output)
+    {
+        const size_t first_escape = raw.find('\\');
+        if (first_escape == std::string_view::npos) {
+            output = QByteArray(raw.data(), static_cast<qsizetype>(raw.size()));
+            return true;
+        }
+
+        // Escapes never expand, so the raw size is enough.
+        QByteArray buffer(static_cast<qsizetype>(raw.size()), Qt::Uninitialized);
+        char *const begin = buffer.data();
+        char *out = begin;
+
+        const char *p = raw.data();
+        const char *const end = p + raw.size();
+        while (p < end) {
+            const char *escape = static_cast<const char *>(std::memchr(p, '\\', end - p));
+            if (!escape) {
+                escape = end;
+            }
+            std::memcpy(out, p, escape - p);
+            out += escape - p;
+            p = escape;
+            if (p == end) {
+                break;
+            }
+            if ((end - p) < 2) {
+                return false;
+            }
+            if (p[1] != 'u') {
+                const char16_t unit = decode_escape(p[1]);
+                if (unit == 0) {
+                    return false;
+                }
+                *out++ = static_cast<char>(unit);
+                p += 2;
+                continue;
+            }
+
+            int32_t unit = ((end - p) >= 6) ? decode_hex4(p + 2) : -1;
+            if (unit < 0) {
+                return false;
+            }
+            p += 6;
+            char32_t code_point = static_cast<char32_t>(unit);
+            if ((unit >= 0xD800) && (unit <= 0xDBFF)) {
+                // Combine a surrogate pair, which takes twelve bytes for four.
+                const int32_t low = (((end - p) >= 6) && (p[0] == '\\') && (p[1] == 'u'))
+                                        ? decode_hex4(p + 2)
+                                        : -1;
+                if ((low >= 0xDC00) && (low <= 0xDFFF)) {
+                    code_point = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                } else {
+                    code_point = REPLACEMENT_CHARACTER;
+                }
+            } else if ((unit >= 0xDC00) && (unit <= 0xDFFF)) {
+                code_point = REPLACEMENT_CHARACTER;
+            }
+            out = encode_utf8(code_point, out);
+        }
+
+        buffer.truncate(out - begin);
+        output = std::move(buffer);
+        return true;
+    }
+
+    // Encodes UTF-16 as UTF-8 into a reused buffer. Unpaired surrogates
+    // become U+FFFD, like they do in QString::toUtf8().
+    inline std::string_view encode_utf8(QStringView text, std::string &buffer)
+    {
+        // Every UTF-16 code unit takes at most three bytes.
+        buffer.resize(static_cast<size_t>(text.size()) * 3);
+        char *const begin = buffer.data();
+        char *out = begin;
+
+        const char16_t *p = text.utf16();
+        const char16_t *const end = p + text.size();
+        while (p < end) {
+            const char16_t unit = *p++;
+            if (unit < 0x80) {
+                *out++ = static_cast<char>(unit);
+            } else if (!QChar::isSurrogate(unit)) {
+                out = encode_utf8(unit, out);
+            } else if (QChar::isHighSurrogate(unit) && (p < end) && QChar::isLowSurrogate(*p)) {
+                out = encode_utf8(QChar::surrogateToUcs4(unit, *p++), out);
+            } else {
+                out = encode_utf8(REPLACEMENT_CHARACTER, out);
+            }
+        }
+        return {begin, static_cast<size_t>(out - begin)};
+    }
+
 } // namespace
 
 namespace glz {
@@ -67,8 +365,8 @@ namespace glz {
         template<auto Opts>
         static inline void op(const QString &value, auto &&...args) noexcept
         {
-            const QByteArray utf8{value.toUtf8()};
-            const std::string str{utf8.toStdString()};
+            thread_local std::string buffer;
+            const std::string_view str = encode_utf8(QStringView(value), buffer);
             glz::serialize<JSON>::op<Opts>(str, args...);
         }
     };
@@ -77,11 +375,16 @@ namespace glz {
     struct from<JSON, QString>
     {
         template<auto Opts>
-        static inline void op(QString &value, auto &&...args) noexcept
+        static inline void op(QString &value, auto &&ctx, auto &&...args) noexcept
         {
-            std::string str;
-            glz::parse<JSON>::op<Opts>(str, args...);
-            value = QString::fromUtf8(str);
+            std::string_view raw;
+            glz::parse<JSON>::op<Opts>(raw, ctx, args...);
+            if (bool(ctx.error)) {
+                return;
+            }
+            if (!decode_json_string(raw, value)) {
+                ctx.error = glz::error_code::syntax_error;
+            }
         }
     };
 
@@ -102,11 +405,16 @@ namespace glz {
     struct from<JSON, QByteArray>
     {
         template<auto Opts>
-        static inline void op(QByteArray &value, auto &&...args) noexcept
+        static inline void op(QByteArray &value, auto &&ctx, auto &&...args) noexcept
         {
-            std::string str;
-            glz::parse<JSON>::op<Opts>(str, args...);
-            value = QByteArray::fromStdString(str);
+            std::string_view raw;
+            glz::parse<JSON>::op<Opts>(raw, ctx, args...);
+            if (bool(ctx.error)) {
+                return;
+            }
+            if (!decode_json_string(raw, value)) {
+                ctx.error = glz::error_code::syntax_error;
+            }
         }
     };
 
@@ -136,11 +444,98 @@ namespace glz {
         }
     };
 
+    // ----- BEVE -----
+
+    template<>
+    struct to<BEVE, QString>
+    {
+        template<auto Opts>
+        static inline void op(const QString &value, auto &&...args) noexcept
+        {
+            thread_local std::string buffer;
+            const std::string_view str = encode_utf8(QStringView(value), buffer);
+            glz::serialize<BEVE>::op<Opts>(str, args...);
+        }
+    };
+
+    template<>
+    struct from<BEVE, QString>
+    {
+        template<auto Opts>
+        static inline void op(QString &value, auto &&ctx, auto &&...args) noexcept
+        {
+            std::string_view raw;
+            glz::parse<BEVE>::op<Opts>(raw, ctx, args...);
+            if (!bool(ctx.error)) {
+                value = QString::fromUtf8(raw.data(), static_cast<qsizetype>(raw.size()));
+            }
+        }
+    };
+
+    template<>
+    struct to<BEVE, QByteArray>
+    {
+        template<auto Opts>
+        static inline void op(const QByteArray &value, auto &&...args) noexcept
+        {
+            const std::string_view str(value.constData(), value.size());
+            glz::serialize<BEVE>::op<Opts>(str, args...);
+        }
+    };
+
+    template<>
+    struct from<BEVE, QByteArray>
+    {
+        template<auto Opts>
+        static inline void op(QByteArray &value, auto &&ctx, auto &&...args) noexcept
+        {
+            std::string_view raw;
+            glz::parse<BEVE>::op<Opts>(raw, ctx, args...);
+            if (!bool(ctx.error)) {
+                value = QByteArray(raw.data(), static_cast<qsizetype>(raw.size()));
+            }
+        }
+    };
+
+    // Invalid dates are stored as the smallest timestamp.
+    constexpr int64_t INVALID_BEVE_DATE = std::numeric_limits<int64_t>::min();
+
+    template<>
+    struct to<BEVE, QDateTime>
+    {
+        template<auto Opts>
+        static inline void op(const QDateTime &dt, auto &&...args) noexcept
+        {
+            const int64_t msecs = dt.isValid() ? dt.toMSecsSinceEpoch() : INVALID_BEVE_DATE;
+            glz::serialize<BEVE>::op<Opts>(msecs, args...);
+        }
+    };
+
+    template<>
+    struct from<BEVE, QDateTime>
+    {
+        template<auto Opts>
+        static inline void op(QDateTime &dt, auto &&ctx, auto &&...args) noexcept
+        {
+            int64_t msecs{0};
+            glz::parse<BEVE>::op<Opts>(msecs, ctx, args...);
+            if (!bool(ctx.error)) {
+                dt = (msecs == INVALID_BEVE_DATE)
+                         ? QDateTime()
+                         : QDateTime::fromMSecsSinceEpoch(msecs, QTimeZone::UTC);
+            }
+        }
+    };
+
     // ----- maps with QString and QByteArray keys -----
 
-    template<template<typename, typename> class Map, typename Key, typename T>
-        requires is_supported_map_with_qt_key<Map, Key, T>
-    struct to<JSON, Map<Key, T>>
+    // Maps are written through a copy with std::string keys, in both formats.
+    template<uint32_t Format>
+    constexpr bool is_qt_map_format = (Format == JSON) || (Format == BEVE);
+
+    template<uint32_t Format, template<typename, typename> class Map, typename Key, typename T>
+        requires is_qt_map_format<Format> && is_supported_map_with_qt_key<Map, Key, T>
+    struct to<Format, Map<Key, T>>
     {
         template<auto Opts>
         static void op(const Map<Key, T> &map, auto &&...args) noexcept
@@ -156,19 +551,20 @@ namespace glz {
                     std_map.emplace(s, std::move(v));
                 }
             }
-            glz::serialize<JSON>::op<Opts>(std_map, std::forward<decltype(args)>(args)...);
+            glz::serialize<Format>::template op<Opts>(std_map,
+                                                      std::forward<decltype(args)>(args)...);
         }
     };
 
-    template<template<typename, typename> class Map, typename Key, typename T>
-        requires is_supported_map_with_qt_key<Map, Key, T>
-    struct from<JSON, Map<Key, T>>
+    template<uint32_t Format, template<typename, typename> class Map, typename Key, typename T>
+        requires is_qt_map_format<Format> && is_supported_map_with_qt_key<Map, Key, T>
+    struct from<Format, Map<Key, T>>
     {
         template<auto Opts>
         static void op(Map<Key, T> &map, auto &&...args) noexcept
         {
             Map<std::string, T> std_map;
-            glz::parse<JSON>::op<Opts>(std_map, std::forward<decltype(args)>(args)...);
+            glz::parse<Format>::template op<Opts>(std_map, std::forward<decltype(args)>(args)...);
             map.clear();
             for (auto &[k, v] : std_map) {
                 if constexpr (is_qbytearray<Key>) {
@@ -0,0 +1,79 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "util/intern.h"
+
+#include <QHashFunctions>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringView>
+
+#include <array>
+#include <unordered_set>
+
+namespace {
+
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(QStringView text) const noexcept { return qHash(text); }
+    };
+
+    struct Equal
+    {
+        using is_transparent = void;
+        bool operator()(QStringView a, QStringView b) const noexcept { return a == b; }
+    };
+
+    // The table is split into shards so that threads building items at the
+    // same time rarely wait on each other.
+    struct Shard
+    {
+        QMutex mutex;
+        std::unordered_set<QString, Hash, Equal> strings;
+    };
+
+    constexpr size_t SHARD_COUNT = 16;
+
+    std::array<Shard, SHARD_COUNT> &shards()
+    {
+        static std::array<Shard, SHARD_COUNT> instance;
+        return instance;
+    }
+
+} // namespace
+
+QString intern::string(const QString &text)
+{
+    if (text.isEmpty()) {
+        return QString();
+    }
+
+    // Use the high bits to pick a shard, since the set uses the low ones.
+    const size_t hash = Hash{}(text);
+    Shard &shard = shards()[(hash >> (sizeof(size_t) * 4)) % SHARD_COUNT];
+
+    QMutexLocker locker(&shard.mutex);
+    const auto it = shard.strings.find(QStringView(text));
+    if (it != shard.strings.end()) {
+        return *it;
+    }
+
+    // Strings decoded from JSON may have spare capacity, which the table
+    // would otherwise keep alive for the life of the process.
+    QString copy = text;
+    if (copy.capacity() > copy.size()) {
+        copy.squeeze();
+    }
+    return *shard.strings.insert(std::move(copy)).first;
+}
+
+size_t intern::size()
+{
+    size_t total = 0;
+    for (auto &shard : shards()) {
+        QMutexLocker locker(&shard.mutex);
+        total += shard.strings.size();
+    }
+    return total;
+}
@@ -0,0 +1,35 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QString>
+
+#include <cstddef>
+
+// A process-wide table of shared strings.
+//
+// Base types, type lines, icons and mod lines repeat across thousands of
+// items. Interning returns the one shared copy of each distinct string, so
+// items only hold a reference to it, and two interned strings are equal
+// exactly when they point at the same data.
+//
+// The table is never pruned, so only intern text that comes from a bounded
+// vocabulary. Unique strings like item ids and notes should not be interned.
+
+namespace intern {
+
+    // Returns the shared copy of a string, adding it to the table if needed.
+    // This is safe to call from any thread.
+    QString string(const QString &text);
+
+    // Returns true if two interned strings are the same string.
+    inline bool same(const QString &a, const QString &b)
+    {
+        return a.constData() == b.constData();
+    }
+
+    // Returns the number of distinct strings in the table.
+    size_t size();
+
+} // namespace intern
@@ -0,0 +1,47 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "util/json.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <functional>
+#include <map>
+
+namespace {
+
+    using KeyCounts = std::map<std::string, size_t, std::less<>>;
+
+    QMutex s_unknown_keys_mutex;
+    std::map<std::string, KeyCounts, std::less<>> s_unknown_keys;
+
+} // namespace
+
+void json::recordUnknownKey(std::string_view type, std::string_view key)
+{
+    QMutexLocker locker(&s_unknown_keys_mutex);
+    auto types = s_unknown_keys.find(type);
+    if (types == s_unknown_keys.end()) {
+        types = s_unknown_keys.emplace(std::string(type), KeyCounts{}).first;
+    }
+    KeyCounts &keys = types->second;
+    const auto entry = keys.find(key);
+    if (entry != keys.end()) {
+        ++entry->second;
+        return;
+    }
+    keys.emplace(std::string(key), 1);
+    spdlog::warn("json: skipping unknown key '{}' in {}", key, type);
+}
+
+std::vector<json::UnknownKeys> json::unknownKeys()
+{
+    QMutexLocker locker(&s_unknown_keys_mutex);
+    std::vector<UnknownKeys> result;
+    result.reserve(s_unknown_keys.size());
+    for (const auto &[type, keys] : s_unknown_keys) {
+        result.push_back({type, {keys.begin(), keys.end()}});
+    }
+    return result;
+}
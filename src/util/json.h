@@ -4,6 +4,7 @@
 #pragma once
 
 #include "util/glaze_qt.h"
+#include "util/unknownkeys.h"
 
 static_assert(ACQUISITION_USE_GLAZE); // Avoids Qt Creator warnings about unused headers.
 
@@ -14,46 +15,98 @@ static_assert(ACQUISITION_USE_GLAZE); // Avoids Qt Creator warnings about unused
 
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace {
 
-    template<typename T, auto GlazeOpts>
-    bool parse_into_impl(T &output, const QByteArray &data)
+    template<typename T>
+    void log_parse_error(const glz::error_ctx &err, std::string_view str)
     {
-        const std::string_view str(data.constData(), data.size());
-        const auto err = glz::read<GlazeOpts>(output, str);
+        const std::string type_name = typeid(T).name();
+        const std::string error_message = glz::format_error(err, str);
+        spdlog::error("json: glaze error parsing {}: {}", type_name, error_message);
+    }
+
+} // namespace
+
+namespace json {
+
+    // How a call site handles keys that are not part of the target type.
+    //
+    // The mode is a template argument, so each call site only instantiates
+    // the parser it uses.
+    //
+    //  - Strict fails the parse.
+    //  - Permissive skips them. Types declared with JSON_UNKNOWN_KEYS record
+    //    the keys they skip in the same pass, so new fields from the API are
+    //    noticed without failing or parsing the payload again.
+    //
+    enum class Mode { Strict, Permissive };
+
+    template<Mode M, bool NullTerminated, typename T>
+    bool read(T &output, std::string_view str)
+    {
+        constexpr glz::opts opts{.null_terminated = NullTerminated,
+                                 .error_on_unknown_keys = (M == Mode::Strict)};
+
+        const glz::error_ctx err = glz::read<opts>(output, str);
         if (err) {
-            const std::string type_name = typeid(T).name();
-            const std::string error_message = glz::format_error(err, str);
-            spdlog::error("json: glaze error parsing {}: {}", type_name, error_message);
+            log_parse_error<T>(err, str);
             return false;
         }
         return true;
-    };
+    }
 
-} // namespace
+    template<Mode M, typename T>
+    bool parse_into(T &output, const QByteArray &data)
+    {
+        const std::string_view str(data.constData(), data.size());
+        return read<M, true>(output, str);
+    }
 
-namespace json {
+    // Parses a slice of a larger buffer, which is not null-terminated.
+    template<Mode M, typename T>
+    bool parse_into(T &output, std::string_view slice)
+    {
+        return read<M, false>(output, slice);
+    }
 
-    enum class Mode { Strict, Permissive };
+    template<typename T, Mode M>
+    std::pair<T, bool> parse(const QByteArray &data)
+    {
+        T output;
+        const bool ok = parse_into<M>(output, data);
+        return {output, ok};
+    }
 
+    // BEVE is glaze's binary format. It's used for values the app writes and
+    // reads back itself, which don't need to be readable or follow the API.
     template<typename T>
-    bool parse_into(T &output, const QByteArray &data, Mode mode)
+    QByteArray toBinary(const T &value)
     {
-        switch (mode) {
-        case Mode::Strict:
-            return parse_into_impl<T, glz::opts{.error_on_unknown_keys = true}>(output, data);
-        case Mode::Permissive:
-            return parse_into_impl<T, glz::opts{.error_on_unknown_keys = false}>(output, data);
+        std::string buffer;
+        const auto result = glz::write_beve(value, buffer);
+        if (result) {
+            const std::string type_name = typeid(T).name();
+            const std::string error_message = glz::format_error(result, buffer);
+            spdlog::error("json: error serializing {} into beve: {}", type_name, error_message);
+            return {};
         }
+        return QByteArray(buffer.data(), static_cast<qsizetype>(buffer.size()));
     }
 
     template<typename T>
-    std::pair<T, bool> parse(const QByteArray &data, Mode mode)
+    bool parse_binary_into(T &output, const QByteArray &data)
     {
-        T output;
-        const bool ok = parse_into(output, data, mode);
-        return {output, ok};
+        const std::string_view str(data.constData(), data.size());
+        const auto err = glz::read_beve(output, str);
+        if (err) {
+            const std::string type_name = typeid(T).name();
+            const std::string error_message = glz::format_error(err, str);
+            spdlog::error("json: error parsing {} from beve: {}", type_name, error_message);
+            return false;
+        }
+        return true;
     }
 
     template<typename T>
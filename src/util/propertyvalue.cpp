@@ -0,0 +1,180 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "util/propertyvalue.h"
+
+#include <array>
+#include <cstdint>
+
+namespace {
+
+    // Nine digits always fit in an int, and property values never need more.
+    constexpr qsizetype MAX_DIGITS = 9;
+
+    constexpr std::array<double, MAX_DIGITS + 1> POWERS_OF_TEN
+        = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+    constexpr bool isDigit(char16_t c)
+    {
+        return (c >= u'0') && (c <= u'9');
+    }
+
+    // Matches the result of QString::toInt(), which also accepts a null pointer.
+    template<typename T>
+    T result(T value, bool matched, bool *ok)
+    {
+        if (ok) {
+            *ok = matched;
+        }
+        return matched ? value : T{0};
+    }
+
+    bool at(QStringView text, qsizetype pos, char16_t c)
+    {
+        return (pos < text.size()) && (text[pos] == c);
+    }
+
+    // Reads a run of digits and advances pos past it. Returns the number of
+    // digits, or -1 when there are too many of them.
+    qsizetype readDigits(QStringView text, qsizetype &pos, int &value)
+    {
+        const qsizetype start = pos;
+        std::int32_t n = 0;
+        while ((pos < text.size()) && isDigit(text[pos].unicode())) {
+            if (pos - start == MAX_DIGITS) {
+                return -1;
+            }
+            n = n * 10 + (text[pos].unicode() - u'0');
+            ++pos;
+        }
+        value = n;
+        return pos - start;
+    }
+
+    bool readSign(QStringView text, qsizetype &pos)
+    {
+        if (at(text, pos, u'-')) {
+            ++pos;
+            return true;
+        }
+        if (at(text, pos, u'+')) {
+            ++pos;
+        }
+        return false;
+    }
+
+    bool readInt(QStringView text, qsizetype &pos, int &value)
+    {
+        const bool negative = readSign(text, pos);
+        if (readDigits(text, pos, value) <= 0) {
+            return false;
+        }
+        if (negative) {
+            value = -value;
+        }
+        return true;
+    }
+
+    bool readFloat(QStringView text, qsizetype &pos, float &value)
+    {
+        const bool negative = readSign(text, pos);
+
+        int whole = 0;
+        const qsizetype whole_digits = readDigits(text, pos, whole);
+        if (whole_digits < 0) {
+            return false;
+        }
+
+        int fraction = 0;
+        qsizetype fraction_digits = 0;
+        if (at(text, pos, u'.')) {
+            ++pos;
+            fraction_digits = readDigits(text, pos, fraction);
+            if (fraction_digits <= 0) {
+                return false;
+            }
+        }
+        if ((whole_digits == 0) && (fraction_digits == 0)) {
+            return false;
+        }
+
+        const double number = whole + fraction / POWERS_OF_TEN[fraction_digits];
+        value = static_cast<float>(negative ? -number : number);
+        return true;
+    }
+
+} // namespace
+
+int propertyvalue::toInt(QStringView text, bool *ok)
+{
+    qsizetype pos = 0;
+    int value = 0;
+    const bool matched = readInt(text, pos, value) && (pos == text.size());
+    return result(value, matched, ok);
+}
+
+float propertyvalue::toFloat(QStringView text, bool *ok)
+{
+    qsizetype pos = 0;
+    float value = 0;
+    const bool matched = readFloat(text, pos, value) && (pos == text.size());
+    return result(value, matched, ok);
+}
+
+int propertyvalue::toPercent(QStringView text, bool *ok)
+{
+    qsizetype pos = 0;
+    int value = 0;
+    const bool matched = readInt(text, pos, value) && at(text, pos, u'%')
+                         && (pos + 1 == text.size());
+    return result(value, matched, ok);
+}
+
+float propertyvalue::toFloatPercent(QStringView text, bool *ok)
+{
+    qsizetype pos = 0;
+    float value = 0;
+    const bool matched = readFloat(text, pos, value) && at(text, pos, u'%')
+                         && (pos + 1 == text.size());
+    return result(value, matched, ok);
+}
+
+int propertyvalue::toLeadingInt(QStringView text, bool *ok)
+{
+    qsizetype pos = 0;
+    int value = 0;
+    const bool matched = readInt(text, pos, value)
+                         && ((pos == text.size()) || at(text, pos, u' '));
+    return result(value, matched, ok);
+}
+
+bool propertyvalue::toFraction(QStringView text, int &numerator, int &denominator)
+{
+    qsizetype pos = 0;
+    int first = 0;
+    int second = 0;
+    if (!readInt(text, pos, first) || !at(text, pos++, u'/') || !readInt(text, pos, second)
+        || (pos != text.size())) {
+        return false;
+    }
+    numerator = first;
+    denominator = second;
+    return true;
+}
+
+float propertyvalue::toAverage(QStringView text, bool *ok)
+{
+    qsizetype pos = 0;
+    int min = 0;
+    if (readDigits(text, pos, min) <= 0) {
+        return result(0.0f, false, ok);
+    }
+    if (pos == text.size()) {
+        return result(static_cast<float>(min), true, ok);
+    }
+
+    int max = 0;
+    const bool matched = at(text, pos++, u'-') && (readDigits(text, pos, max) > 0)
+                         && (pos == text.size());
+    return result((min + max) / 2.0f, matched, ok);
+}
@@ -0,0 +1,38 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <QStringView>
+
+// Numeric parsers for the values of typed item properties and requirements,
+// such as "12-34", "+20%", "3/10", "1.45" or "20 (Max)".
+//
+// They read the UTF-16 text in place and never allocate, unlike chaining
+// QString::section() or sliced() before a conversion. Like QString::toInt(),
+// each one returns zero and sets ok to false when the text does not match.
+
+namespace propertyvalue {
+
+    // A whole number with an optional sign, e.g. "20" or "+20".
+    int toInt(QStringView text, bool *ok);
+
+    // A decimal number with an optional sign, e.g. "1.45".
+    float toFloat(QStringView text, bool *ok);
+
+    // A whole number followed by a percent sign, e.g. "+20%" or "25%".
+    int toPercent(QStringView text, bool *ok);
+
+    // A decimal number followed by a percent sign, e.g. "5.00%".
+    float toFloatPercent(QStringView text, bool *ok);
+
+    // The first word as a whole number, e.g. "20 (Max)".
+    int toLeadingInt(QStringView text, bool *ok);
+
+    // Two whole numbers separated by a slash, e.g. "3/10".
+    bool toFraction(QStringView text, int &numerator, int &denominator);
+
+    // The midpoint of a range such as "12-34", or a single number like "12".
+    float toAverage(QStringView text, bool *ok);
+
+} // namespace propertyvalue
@@ -0,0 +1,46 @@
+// Copyright (C) 2025 Tom Holz.
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <glaze/glaze.hpp>
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+    // The keys that permissive parses skipped in one type, and how many times
+    // each of them was seen.
+    struct UnknownKeys
+    {
+        std::string type;
+        std::vector<std::pair<std::string, size_t>> keys;
+    };
+
+    // Counts a key that was skipped in a type. This is safe to call from any thread.
+    void recordUnknownKey(std::string_view type, std::string_view key);
+
+    // Returns the table of unknown keys, one entry per type.
+    std::vector<UnknownKeys> unknownKeys();
+
+} // namespace json
+
+// Glaze calls this handler for each key of an object that has no member in the
+// struct, while it skips the key. It goes inside the body of the struct.
+#define JSON_UNKNOWN_KEYS(Type) \
+    void unknownKey(const glz::sv &key, const glz::raw_json & /* value */) \
+    { \
+        json::recordUnknownKey(#Type, key); \
+    }
+
+// Registers the handler with glaze. This goes at global scope after the struct.
+// Structs that already have a glz::meta set unknown_read there instead.
+#define JSON_UNKNOWN_KEYS_META(Type) \
+    template<> \
+    struct glz::meta<Type> \
+    { \
+        static constexpr auto unknown_read = &Type::unknownKey; \
+    }